@@ -30,6 +30,14 @@
  *  algorithm may attempt any number of such reads which must be handled in
  *  a memory safe manner, always returning 0x100.
  *
+ *  Alternatively input can be read using a span callback which fills a
+ *  buffer with a range of input bytes.  Input is then read into a small
+ *  buffer in the state (or directly into the output for Store entries),
+ *  avoiding a callback per byte.  An archive already in memory can be
+ *  accessed directly without any callbacks.  In both cases input bytes
+ *  come from an "input window" which allows multi-byte fields and copies
+ *  to be bounds checked once rather than per byte.
+ *
  *  Output data is written out into a user provided fixed buffer.  If the
  *  output buffer is too small for the output, the inflate algorithm remains
  *  memory safe and won't overstep the buffer, and an error will be signalled.
@@ -51,6 +59,7 @@
  *    - sizeof(char) == 1
  *    - sizeof(short) == 2
  *    - sizeof(int) >= 4
+ *    - sizeof(long long) >= 8 (LOWZIP_FAST_BITREADER and LOWZIP_GZIP only)
  */
 
 #undef LOWZIP_DEBUG  /* Enable manually. */
@@ -59,10 +68,21 @@
 #include <stdio.h>
 #endif
 
-#include <string.h>  /* memset(), strlen() */
+#include <string.h>  /* memset(), strlen(), memchr() */
 #include <stddef.h>  /* ptrdiff_t */
 #include "lowzip.h"
 
+/* With LOWZIP_FAST_CRC32 on x86-64 GCC/Clang builds, a PCLMULQDQ CRC-32
+ * kernel is compiled in and used if CPUID reports support for it.  Define
+ * LOWZIP_NO_CLMUL to leave it out.
+ */
+#if defined(LOWZIP_FAST_CRC32) && defined(__x86_64__) && defined(__GNUC__) && !defined(LOWZIP_NO_CLMUL)
+#define LOWZIP_CRC32_CLMUL
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
 /*
  *  ZIP defines (see ZIP APPNOTE)
  */
@@ -74,15 +94,67 @@
 #define LOWZIP_COMPRESSION_STORE     0
 #define LOWZIP_COMPRESSION_DEFLATE   8
 
+/*
+ *  gzip defines (see RFC 1952) and BGZF (see the SAM/BAM specification)
+ */
+
+#define LOWZIP_GZIP_HEADER_LENGTH    10
+#define LOWZIP_GZIP_TRAILER_LENGTH   8
+#define LOWZIP_GZIP_FHCRC            0x02U
+#define LOWZIP_GZIP_FEXTRA           0x04U
+#define LOWZIP_GZIP_FNAME            0x08U
+#define LOWZIP_GZIP_FCOMMENT         0x10U
+#define LOWZIP_GZIP_FRESERVED        0xe0U
+#define LOWZIP_BGZF_SUBFIELD         0x4342U  /* SI1 'B', SI2 'C'. */
+
 /*
  *  Inflate defines and tables
  */
 
+/* Inflate modes, position in the block level state machine (st->mode). */
+#define LOWZIP_MODE_HEADER       0  /* Block header. */
+#define LOWZIP_MODE_STORED_LEN   1  /* Uncompressed block length. */
+#define LOWZIP_MODE_STORED_COPY  2  /* Uncompressed block data. */
+#define LOWZIP_MODE_TABLE        3  /* Dynamic Huffman table sizes, code length code. */
+#define LOWZIP_MODE_CODELENS     4  /* Dynamic Huffman code lengths. */
+#define LOWZIP_MODE_STATIC       5  /* Static Huffman block data. */
+#define LOWZIP_MODE_DYNAMIC      6  /* Dynamic Huffman block data. */
+#define LOWZIP_MODE_DONE         7  /* Final block done. */
+
 /* Scratch area offset for literal/length Huffman tree. */
 #define LOWZIP_SCRATCH_HUFF_LIT   0
 
 /* Scratch area offset for distance Huffman tree. */
+#if defined(LOWZIP_FAST_HUFFMAN)
+#define LOWZIP_SCRATCH_HUFF_DIST  2314
+#else
 #define LOWZIP_SCRATCH_HUFF_DIST  604
+#endif
+
+#if defined(LOWZIP_FAST_HUFFMAN) || defined(LOWZIP_FAST_STATIC_HUFFMAN)
+#define LOWZIP_FAST_TABLES  /* Lookup table decoding needed. */
+#endif
+
+#if defined(LOWZIP_FAST_TABLES)
+/* Lookup table root bits and maximum table sizes (including sub-tables)
+ * for tables with more than 32 symbols (literal/length) and for smaller
+ * tables (distance, code length).  The sizes are from zlib 'enough' for
+ * complete codes; codes needing more space use the bit-at-a-time decoder.
+ */
+#define LOWZIP_FAST_LIT_BITS      9
+#define LOWZIP_FAST_LIT_SIZE      852
+#define LOWZIP_FAST_DIST_BITS     6
+#define LOWZIP_FAST_DIST_SIZE     592
+
+/* Lookup table entries are 16-bit: bits 12-15 contain the number of bits
+ * consumed, bit 11 is set for a sub-table link, and bits 0-10 contain the
+ * terminal value or the sub-table offset.  For a link, bits 12-15 contain
+ * the sub-table index bit count instead.
+ */
+#define LOWZIP_FAST_LINK          0x0800U
+#define LOWZIP_FAST_VALUE_MASK    0x07ffU
+#define LOWZIP_FAST_INVALID       0x07ffU
+#endif
 
 /* Extra bits for 'length', from RFC 1951 Section 3.2.5.  Index is code - 257,
  * value is extra bits to read for the length value.
@@ -125,35 +197,841 @@ static const unsigned char lowzip_codelen_order[19] = {
 	14U, 1U, 15U
 };
 
+#if defined(LOWZIP_FAST_STATIC_HUFFMAN)
+/* Lookup table for the static literal/length Huffman code, RFC 1951 Section
+ * 3.2.6, in the LOWZIP_FAST_HUFFMAN lookup table format.  Codes are 7-9
+ * bits so there are no sub-tables.
+ */
+static const unsigned short lowzip_static_lit[513] = {
+	9U,  /* Root bits. */
+	0x7100U, 0x8050U, 0x8010U, 0x8118U, 0x7110U, 0x8070U, 0x8030U, 0x90c0U,
+	0x7108U, 0x8060U, 0x8020U, 0x90a0U, 0x8000U, 0x8080U, 0x8040U, 0x90e0U,
+	0x7104U, 0x8058U, 0x8018U, 0x9090U, 0x7114U, 0x8078U, 0x8038U, 0x90d0U,
+	0x710cU, 0x8068U, 0x8028U, 0x90b0U, 0x8008U, 0x8088U, 0x8048U, 0x90f0U,
+	0x7102U, 0x8054U, 0x8014U, 0x811cU, 0x7112U, 0x8074U, 0x8034U, 0x90c8U,
+	0x710aU, 0x8064U, 0x8024U, 0x90a8U, 0x8004U, 0x8084U, 0x8044U, 0x90e8U,
+	0x7106U, 0x805cU, 0x801cU, 0x9098U, 0x7116U, 0x807cU, 0x803cU, 0x90d8U,
+	0x710eU, 0x806cU, 0x802cU, 0x90b8U, 0x800cU, 0x808cU, 0x804cU, 0x90f8U,
+	0x7101U, 0x8052U, 0x8012U, 0x811aU, 0x7111U, 0x8072U, 0x8032U, 0x90c4U,
+	0x7109U, 0x8062U, 0x8022U, 0x90a4U, 0x8002U, 0x8082U, 0x8042U, 0x90e4U,
+	0x7105U, 0x805aU, 0x801aU, 0x9094U, 0x7115U, 0x807aU, 0x803aU, 0x90d4U,
+	0x710dU, 0x806aU, 0x802aU, 0x90b4U, 0x800aU, 0x808aU, 0x804aU, 0x90f4U,
+	0x7103U, 0x8056U, 0x8016U, 0x811eU, 0x7113U, 0x8076U, 0x8036U, 0x90ccU,
+	0x710bU, 0x8066U, 0x8026U, 0x90acU, 0x8006U, 0x8086U, 0x8046U, 0x90ecU,
+	0x7107U, 0x805eU, 0x801eU, 0x909cU, 0x7117U, 0x807eU, 0x803eU, 0x90dcU,
+	0x710fU, 0x806eU, 0x802eU, 0x90bcU, 0x800eU, 0x808eU, 0x804eU, 0x90fcU,
+	0x7100U, 0x8051U, 0x8011U, 0x8119U, 0x7110U, 0x8071U, 0x8031U, 0x90c2U,
+	0x7108U, 0x8061U, 0x8021U, 0x90a2U, 0x8001U, 0x8081U, 0x8041U, 0x90e2U,
+	0x7104U, 0x8059U, 0x8019U, 0x9092U, 0x7114U, 0x8079U, 0x8039U, 0x90d2U,
+	0x710cU, 0x8069U, 0x8029U, 0x90b2U, 0x8009U, 0x8089U, 0x8049U, 0x90f2U,
+	0x7102U, 0x8055U, 0x8015U, 0x811dU, 0x7112U, 0x8075U, 0x8035U, 0x90caU,
+	0x710aU, 0x8065U, 0x8025U, 0x90aaU, 0x8005U, 0x8085U, 0x8045U, 0x90eaU,
+	0x7106U, 0x805dU, 0x801dU, 0x909aU, 0x7116U, 0x807dU, 0x803dU, 0x90daU,
+	0x710eU, 0x806dU, 0x802dU, 0x90baU, 0x800dU, 0x808dU, 0x804dU, 0x90faU,
+	0x7101U, 0x8053U, 0x8013U, 0x811bU, 0x7111U, 0x8073U, 0x8033U, 0x90c6U,
+	0x7109U, 0x8063U, 0x8023U, 0x90a6U, 0x8003U, 0x8083U, 0x8043U, 0x90e6U,
+	0x7105U, 0x805bU, 0x801bU, 0x9096U, 0x7115U, 0x807bU, 0x803bU, 0x90d6U,
+	0x710dU, 0x806bU, 0x802bU, 0x90b6U, 0x800bU, 0x808bU, 0x804bU, 0x90f6U,
+	0x7103U, 0x8057U, 0x8017U, 0x811fU, 0x7113U, 0x8077U, 0x8037U, 0x90ceU,
+	0x710bU, 0x8067U, 0x8027U, 0x90aeU, 0x8007U, 0x8087U, 0x8047U, 0x90eeU,
+	0x7107U, 0x805fU, 0x801fU, 0x909eU, 0x7117U, 0x807fU, 0x803fU, 0x90deU,
+	0x710fU, 0x806fU, 0x802fU, 0x90beU, 0x800fU, 0x808fU, 0x804fU, 0x90feU,
+	0x7100U, 0x8050U, 0x8010U, 0x8118U, 0x7110U, 0x8070U, 0x8030U, 0x90c1U,
+	0x7108U, 0x8060U, 0x8020U, 0x90a1U, 0x8000U, 0x8080U, 0x8040U, 0x90e1U,
+	0x7104U, 0x8058U, 0x8018U, 0x9091U, 0x7114U, 0x8078U, 0x8038U, 0x90d1U,
+	0x710cU, 0x8068U, 0x8028U, 0x90b1U, 0x8008U, 0x8088U, 0x8048U, 0x90f1U,
+	0x7102U, 0x8054U, 0x8014U, 0x811cU, 0x7112U, 0x8074U, 0x8034U, 0x90c9U,
+	0x710aU, 0x8064U, 0x8024U, 0x90a9U, 0x8004U, 0x8084U, 0x8044U, 0x90e9U,
+	0x7106U, 0x805cU, 0x801cU, 0x9099U, 0x7116U, 0x807cU, 0x803cU, 0x90d9U,
+	0x710eU, 0x806cU, 0x802cU, 0x90b9U, 0x800cU, 0x808cU, 0x804cU, 0x90f9U,
+	0x7101U, 0x8052U, 0x8012U, 0x811aU, 0x7111U, 0x8072U, 0x8032U, 0x90c5U,
+	0x7109U, 0x8062U, 0x8022U, 0x90a5U, 0x8002U, 0x8082U, 0x8042U, 0x90e5U,
+	0x7105U, 0x805aU, 0x801aU, 0x9095U, 0x7115U, 0x807aU, 0x803aU, 0x90d5U,
+	0x710dU, 0x806aU, 0x802aU, 0x90b5U, 0x800aU, 0x808aU, 0x804aU, 0x90f5U,
+	0x7103U, 0x8056U, 0x8016U, 0x811eU, 0x7113U, 0x8076U, 0x8036U, 0x90cdU,
+	0x710bU, 0x8066U, 0x8026U, 0x90adU, 0x8006U, 0x8086U, 0x8046U, 0x90edU,
+	0x7107U, 0x805eU, 0x801eU, 0x909dU, 0x7117U, 0x807eU, 0x803eU, 0x90ddU,
+	0x710fU, 0x806eU, 0x802eU, 0x90bdU, 0x800eU, 0x808eU, 0x804eU, 0x90fdU,
+	0x7100U, 0x8051U, 0x8011U, 0x8119U, 0x7110U, 0x8071U, 0x8031U, 0x90c3U,
+	0x7108U, 0x8061U, 0x8021U, 0x90a3U, 0x8001U, 0x8081U, 0x8041U, 0x90e3U,
+	0x7104U, 0x8059U, 0x8019U, 0x9093U, 0x7114U, 0x8079U, 0x8039U, 0x90d3U,
+	0x710cU, 0x8069U, 0x8029U, 0x90b3U, 0x8009U, 0x8089U, 0x8049U, 0x90f3U,
+	0x7102U, 0x8055U, 0x8015U, 0x811dU, 0x7112U, 0x8075U, 0x8035U, 0x90cbU,
+	0x710aU, 0x8065U, 0x8025U, 0x90abU, 0x8005U, 0x8085U, 0x8045U, 0x90ebU,
+	0x7106U, 0x805dU, 0x801dU, 0x909bU, 0x7116U, 0x807dU, 0x803dU, 0x90dbU,
+	0x710eU, 0x806dU, 0x802dU, 0x90bbU, 0x800dU, 0x808dU, 0x804dU, 0x90fbU,
+	0x7101U, 0x8053U, 0x8013U, 0x811bU, 0x7111U, 0x8073U, 0x8033U, 0x90c7U,
+	0x7109U, 0x8063U, 0x8023U, 0x90a7U, 0x8003U, 0x8083U, 0x8043U, 0x90e7U,
+	0x7105U, 0x805bU, 0x801bU, 0x9097U, 0x7115U, 0x807bU, 0x803bU, 0x90d7U,
+	0x710dU, 0x806bU, 0x802bU, 0x90b7U, 0x800bU, 0x808bU, 0x804bU, 0x90f7U,
+	0x7103U, 0x8057U, 0x8017U, 0x811fU, 0x7113U, 0x8077U, 0x8037U, 0x90cfU,
+	0x710bU, 0x8067U, 0x8027U, 0x90afU, 0x8007U, 0x8087U, 0x8047U, 0x90efU,
+	0x7107U, 0x805fU, 0x801fU, 0x909fU, 0x7117U, 0x807fU, 0x803fU, 0x90dfU,
+	0x710fU, 0x806fU, 0x802fU, 0x90bfU, 0x800fU, 0x808fU, 0x804fU, 0x90ffU
+};
+
+/* Lookup table for the static distance code: fixed 5-bit codes. */
+static const unsigned short lowzip_static_dist[33] = {
+	5U,  /* Root bits. */
+	0x5000U, 0x5010U, 0x5008U, 0x5018U, 0x5004U, 0x5014U, 0x500cU, 0x501cU,
+	0x5002U, 0x5012U, 0x500aU, 0x501aU, 0x5006U, 0x5016U, 0x500eU, 0x501eU,
+	0x5001U, 0x5011U, 0x5009U, 0x5019U, 0x5005U, 0x5015U, 0x500dU, 0x501dU,
+	0x5003U, 0x5013U, 0x500bU, 0x501bU, 0x5007U, 0x5017U, 0x500fU, 0x501fU
+};
+#endif  /* LOWZIP_FAST_STATIC_HUFFMAN */
+
+#if defined(LOWZIP_FAST_CRC32)
+/* CRC-32 lookup tables for slicing-by-8: table 0 is the usual byte-wise
+ * table, table k gives the CRC contribution of a byte followed by k zero
+ * bytes.
+ */
+static const unsigned int lowzip_crc32_table[8][256] = {
+	{
+		0x00000000UL, 0x77073096UL, 0xee0e612cUL, 0x990951baUL, 0x076dc419UL, 0x706af48fUL,
+		0xe963a535UL, 0x9e6495a3UL, 0x0edb8832UL, 0x79dcb8a4UL, 0xe0d5e91eUL, 0x97d2d988UL,
+		0x09b64c2bUL, 0x7eb17cbdUL, 0xe7b82d07UL, 0x90bf1d91UL, 0x1db71064UL, 0x6ab020f2UL,
+		0xf3b97148UL, 0x84be41deUL, 0x1adad47dUL, 0x6ddde4ebUL, 0xf4d4b551UL, 0x83d385c7UL,
+		0x136c9856UL, 0x646ba8c0UL, 0xfd62f97aUL, 0x8a65c9ecUL, 0x14015c4fUL, 0x63066cd9UL,
+		0xfa0f3d63UL, 0x8d080df5UL, 0x3b6e20c8UL, 0x4c69105eUL, 0xd56041e4UL, 0xa2677172UL,
+		0x3c03e4d1UL, 0x4b04d447UL, 0xd20d85fdUL, 0xa50ab56bUL, 0x35b5a8faUL, 0x42b2986cUL,
+		0xdbbbc9d6UL, 0xacbcf940UL, 0x32d86ce3UL, 0x45df5c75UL, 0xdcd60dcfUL, 0xabd13d59UL,
+		0x26d930acUL, 0x51de003aUL, 0xc8d75180UL, 0xbfd06116UL, 0x21b4f4b5UL, 0x56b3c423UL,
+		0xcfba9599UL, 0xb8bda50fUL, 0x2802b89eUL, 0x5f058808UL, 0xc60cd9b2UL, 0xb10be924UL,
+		0x2f6f7c87UL, 0x58684c11UL, 0xc1611dabUL, 0xb6662d3dUL, 0x76dc4190UL, 0x01db7106UL,
+		0x98d220bcUL, 0xefd5102aUL, 0x71b18589UL, 0x06b6b51fUL, 0x9fbfe4a5UL, 0xe8b8d433UL,
+		0x7807c9a2UL, 0x0f00f934UL, 0x9609a88eUL, 0xe10e9818UL, 0x7f6a0dbbUL, 0x086d3d2dUL,
+		0x91646c97UL, 0xe6635c01UL, 0x6b6b51f4UL, 0x1c6c6162UL, 0x856530d8UL, 0xf262004eUL,
+		0x6c0695edUL, 0x1b01a57bUL, 0x8208f4c1UL, 0xf50fc457UL, 0x65b0d9c6UL, 0x12b7e950UL,
+		0x8bbeb8eaUL, 0xfcb9887cUL, 0x62dd1ddfUL, 0x15da2d49UL, 0x8cd37cf3UL, 0xfbd44c65UL,
+		0x4db26158UL, 0x3ab551ceUL, 0xa3bc0074UL, 0xd4bb30e2UL, 0x4adfa541UL, 0x3dd895d7UL,
+		0xa4d1c46dUL, 0xd3d6f4fbUL, 0x4369e96aUL, 0x346ed9fcUL, 0xad678846UL, 0xda60b8d0UL,
+		0x44042d73UL, 0x33031de5UL, 0xaa0a4c5fUL, 0xdd0d7cc9UL, 0x5005713cUL, 0x270241aaUL,
+		0xbe0b1010UL, 0xc90c2086UL, 0x5768b525UL, 0x206f85b3UL, 0xb966d409UL, 0xce61e49fUL,
+		0x5edef90eUL, 0x29d9c998UL, 0xb0d09822UL, 0xc7d7a8b4UL, 0x59b33d17UL, 0x2eb40d81UL,
+		0xb7bd5c3bUL, 0xc0ba6cadUL, 0xedb88320UL, 0x9abfb3b6UL, 0x03b6e20cUL, 0x74b1d29aUL,
+		0xead54739UL, 0x9dd277afUL, 0x04db2615UL, 0x73dc1683UL, 0xe3630b12UL, 0x94643b84UL,
+		0x0d6d6a3eUL, 0x7a6a5aa8UL, 0xe40ecf0bUL, 0x9309ff9dUL, 0x0a00ae27UL, 0x7d079eb1UL,
+		0xf00f9344UL, 0x8708a3d2UL, 0x1e01f268UL, 0x6906c2feUL, 0xf762575dUL, 0x806567cbUL,
+		0x196c3671UL, 0x6e6b06e7UL, 0xfed41b76UL, 0x89d32be0UL, 0x10da7a5aUL, 0x67dd4accUL,
+		0xf9b9df6fUL, 0x8ebeeff9UL, 0x17b7be43UL, 0x60b08ed5UL, 0xd6d6a3e8UL, 0xa1d1937eUL,
+		0x38d8c2c4UL, 0x4fdff252UL, 0xd1bb67f1UL, 0xa6bc5767UL, 0x3fb506ddUL, 0x48b2364bUL,
+		0xd80d2bdaUL, 0xaf0a1b4cUL, 0x36034af6UL, 0x41047a60UL, 0xdf60efc3UL, 0xa867df55UL,
+		0x316e8eefUL, 0x4669be79UL, 0xcb61b38cUL, 0xbc66831aUL, 0x256fd2a0UL, 0x5268e236UL,
+		0xcc0c7795UL, 0xbb0b4703UL, 0x220216b9UL, 0x5505262fUL, 0xc5ba3bbeUL, 0xb2bd0b28UL,
+		0x2bb45a92UL, 0x5cb36a04UL, 0xc2d7ffa7UL, 0xb5d0cf31UL, 0x2cd99e8bUL, 0x5bdeae1dUL,
+		0x9b64c2b0UL, 0xec63f226UL, 0x756aa39cUL, 0x026d930aUL, 0x9c0906a9UL, 0xeb0e363fUL,
+		0x72076785UL, 0x05005713UL, 0x95bf4a82UL, 0xe2b87a14UL, 0x7bb12baeUL, 0x0cb61b38UL,
+		0x92d28e9bUL, 0xe5d5be0dUL, 0x7cdcefb7UL, 0x0bdbdf21UL, 0x86d3d2d4UL, 0xf1d4e242UL,
+		0x68ddb3f8UL, 0x1fda836eUL, 0x81be16cdUL, 0xf6b9265bUL, 0x6fb077e1UL, 0x18b74777UL,
+		0x88085ae6UL, 0xff0f6a70UL, 0x66063bcaUL, 0x11010b5cUL, 0x8f659effUL, 0xf862ae69UL,
+		0x616bffd3UL, 0x166ccf45UL, 0xa00ae278UL, 0xd70dd2eeUL, 0x4e048354UL, 0x3903b3c2UL,
+		0xa7672661UL, 0xd06016f7UL, 0x4969474dUL, 0x3e6e77dbUL, 0xaed16a4aUL, 0xd9d65adcUL,
+		0x40df0b66UL, 0x37d83bf0UL, 0xa9bcae53UL, 0xdebb9ec5UL, 0x47b2cf7fUL, 0x30b5ffe9UL,
+		0xbdbdf21cUL, 0xcabac28aUL, 0x53b39330UL, 0x24b4a3a6UL, 0xbad03605UL, 0xcdd70693UL,
+		0x54de5729UL, 0x23d967bfUL, 0xb3667a2eUL, 0xc4614ab8UL, 0x5d681b02UL, 0x2a6f2b94UL,
+		0xb40bbe37UL, 0xc30c8ea1UL, 0x5a05df1bUL, 0x2d02ef8dUL
+	},
+	{
+		0x00000000UL, 0x191b3141UL, 0x32366282UL, 0x2b2d53c3UL, 0x646cc504UL, 0x7d77f445UL,
+		0x565aa786UL, 0x4f4196c7UL, 0xc8d98a08UL, 0xd1c2bb49UL, 0xfaefe88aUL, 0xe3f4d9cbUL,
+		0xacb54f0cUL, 0xb5ae7e4dUL, 0x9e832d8eUL, 0x87981ccfUL, 0x4ac21251UL, 0x53d92310UL,
+		0x78f470d3UL, 0x61ef4192UL, 0x2eaed755UL, 0x37b5e614UL, 0x1c98b5d7UL, 0x05838496UL,
+		0x821b9859UL, 0x9b00a918UL, 0xb02dfadbUL, 0xa936cb9aUL, 0xe6775d5dUL, 0xff6c6c1cUL,
+		0xd4413fdfUL, 0xcd5a0e9eUL, 0x958424a2UL, 0x8c9f15e3UL, 0xa7b24620UL, 0xbea97761UL,
+		0xf1e8e1a6UL, 0xe8f3d0e7UL, 0xc3de8324UL, 0xdac5b265UL, 0x5d5daeaaUL, 0x44469febUL,
+		0x6f6bcc28UL, 0x7670fd69UL, 0x39316baeUL, 0x202a5aefUL, 0x0b07092cUL, 0x121c386dUL,
+		0xdf4636f3UL, 0xc65d07b2UL, 0xed705471UL, 0xf46b6530UL, 0xbb2af3f7UL, 0xa231c2b6UL,
+		0x891c9175UL, 0x9007a034UL, 0x179fbcfbUL, 0x0e848dbaUL, 0x25a9de79UL, 0x3cb2ef38UL,
+		0x73f379ffUL, 0x6ae848beUL, 0x41c51b7dUL, 0x58de2a3cUL, 0xf0794f05UL, 0xe9627e44UL,
+		0xc24f2d87UL, 0xdb541cc6UL, 0x94158a01UL, 0x8d0ebb40UL, 0xa623e883UL, 0xbf38d9c2UL,
+		0x38a0c50dUL, 0x21bbf44cUL, 0x0a96a78fUL, 0x138d96ceUL, 0x5ccc0009UL, 0x45d73148UL,
+		0x6efa628bUL, 0x77e153caUL, 0xbabb5d54UL, 0xa3a06c15UL, 0x888d3fd6UL, 0x91960e97UL,
+		0xded79850UL, 0xc7cca911UL, 0xece1fad2UL, 0xf5facb93UL, 0x7262d75cUL, 0x6b79e61dUL,
+		0x4054b5deUL, 0x594f849fUL, 0x160e1258UL, 0x0f152319UL, 0x243870daUL, 0x3d23419bUL,
+		0x65fd6ba7UL, 0x7ce65ae6UL, 0x57cb0925UL, 0x4ed03864UL, 0x0191aea3UL, 0x188a9fe2UL,
+		0x33a7cc21UL, 0x2abcfd60UL, 0xad24e1afUL, 0xb43fd0eeUL, 0x9f12832dUL, 0x8609b26cUL,
+		0xc94824abUL, 0xd05315eaUL, 0xfb7e4629UL, 0xe2657768UL, 0x2f3f79f6UL, 0x362448b7UL,
+		0x1d091b74UL, 0x04122a35UL, 0x4b53bcf2UL, 0x52488db3UL, 0x7965de70UL, 0x607eef31UL,
+		0xe7e6f3feUL, 0xfefdc2bfUL, 0xd5d0917cUL, 0xcccba03dUL, 0x838a36faUL, 0x9a9107bbUL,
+		0xb1bc5478UL, 0xa8a76539UL, 0x3b83984bUL, 0x2298a90aUL, 0x09b5fac9UL, 0x10aecb88UL,
+		0x5fef5d4fUL, 0x46f46c0eUL, 0x6dd93fcdUL, 0x74c20e8cUL, 0xf35a1243UL, 0xea412302UL,
+		0xc16c70c1UL, 0xd8774180UL, 0x9736d747UL, 0x8e2de606UL, 0xa500b5c5UL, 0xbc1b8484UL,
+		0x71418a1aUL, 0x685abb5bUL, 0x4377e898UL, 0x5a6cd9d9UL, 0x152d4f1eUL, 0x0c367e5fUL,
+		0x271b2d9cUL, 0x3e001cddUL, 0xb9980012UL, 0xa0833153UL, 0x8bae6290UL, 0x92b553d1UL,
+		0xddf4c516UL, 0xc4eff457UL, 0xefc2a794UL, 0xf6d996d5UL, 0xae07bce9UL, 0xb71c8da8UL,
+		0x9c31de6bUL, 0x852aef2aUL, 0xca6b79edUL, 0xd37048acUL, 0xf85d1b6fUL, 0xe1462a2eUL,
+		0x66de36e1UL, 0x7fc507a0UL, 0x54e85463UL, 0x4df36522UL, 0x02b2f3e5UL, 0x1ba9c2a4UL,
+		0x30849167UL, 0x299fa026UL, 0xe4c5aeb8UL, 0xfdde9ff9UL, 0xd6f3cc3aUL, 0xcfe8fd7bUL,
+		0x80a96bbcUL, 0x99b25afdUL, 0xb29f093eUL, 0xab84387fUL, 0x2c1c24b0UL, 0x350715f1UL,
+		0x1e2a4632UL, 0x07317773UL, 0x4870e1b4UL, 0x516bd0f5UL, 0x7a468336UL, 0x635db277UL,
+		0xcbfad74eUL, 0xd2e1e60fUL, 0xf9ccb5ccUL, 0xe0d7848dUL, 0xaf96124aUL, 0xb68d230bUL,
+		0x9da070c8UL, 0x84bb4189UL, 0x03235d46UL, 0x1a386c07UL, 0x31153fc4UL, 0x280e0e85UL,
+		0x674f9842UL, 0x7e54a903UL, 0x5579fac0UL, 0x4c62cb81UL, 0x8138c51fUL, 0x9823f45eUL,
+		0xb30ea79dUL, 0xaa1596dcUL, 0xe554001bUL, 0xfc4f315aUL, 0xd7626299UL, 0xce7953d8UL,
+		0x49e14f17UL, 0x50fa7e56UL, 0x7bd72d95UL, 0x62cc1cd4UL, 0x2d8d8a13UL, 0x3496bb52UL,
+		0x1fbbe891UL, 0x06a0d9d0UL, 0x5e7ef3ecUL, 0x4765c2adUL, 0x6c48916eUL, 0x7553a02fUL,
+		0x3a1236e8UL, 0x230907a9UL, 0x0824546aUL, 0x113f652bUL, 0x96a779e4UL, 0x8fbc48a5UL,
+		0xa4911b66UL, 0xbd8a2a27UL, 0xf2cbbce0UL, 0xebd08da1UL, 0xc0fdde62UL, 0xd9e6ef23UL,
+		0x14bce1bdUL, 0x0da7d0fcUL, 0x268a833fUL, 0x3f91b27eUL, 0x70d024b9UL, 0x69cb15f8UL,
+		0x42e6463bUL, 0x5bfd777aUL, 0xdc656bb5UL, 0xc57e5af4UL, 0xee530937UL, 0xf7483876UL,
+		0xb809aeb1UL, 0xa1129ff0UL, 0x8a3fcc33UL, 0x9324fd72UL
+	},
+	{
+		0x00000000UL, 0x01c26a37UL, 0x0384d46eUL, 0x0246be59UL, 0x0709a8dcUL, 0x06cbc2ebUL,
+		0x048d7cb2UL, 0x054f1685UL, 0x0e1351b8UL, 0x0fd13b8fUL, 0x0d9785d6UL, 0x0c55efe1UL,
+		0x091af964UL, 0x08d89353UL, 0x0a9e2d0aUL, 0x0b5c473dUL, 0x1c26a370UL, 0x1de4c947UL,
+		0x1fa2771eUL, 0x1e601d29UL, 0x1b2f0bacUL, 0x1aed619bUL, 0x18abdfc2UL, 0x1969b5f5UL,
+		0x1235f2c8UL, 0x13f798ffUL, 0x11b126a6UL, 0x10734c91UL, 0x153c5a14UL, 0x14fe3023UL,
+		0x16b88e7aUL, 0x177ae44dUL, 0x384d46e0UL, 0x398f2cd7UL, 0x3bc9928eUL, 0x3a0bf8b9UL,
+		0x3f44ee3cUL, 0x3e86840bUL, 0x3cc03a52UL, 0x3d025065UL, 0x365e1758UL, 0x379c7d6fUL,
+		0x35dac336UL, 0x3418a901UL, 0x3157bf84UL, 0x3095d5b3UL, 0x32d36beaUL, 0x331101ddUL,
+		0x246be590UL, 0x25a98fa7UL, 0x27ef31feUL, 0x262d5bc9UL, 0x23624d4cUL, 0x22a0277bUL,
+		0x20e69922UL, 0x2124f315UL, 0x2a78b428UL, 0x2bbade1fUL, 0x29fc6046UL, 0x283e0a71UL,
+		0x2d711cf4UL, 0x2cb376c3UL, 0x2ef5c89aUL, 0x2f37a2adUL, 0x709a8dc0UL, 0x7158e7f7UL,
+		0x731e59aeUL, 0x72dc3399UL, 0x7793251cUL, 0x76514f2bUL, 0x7417f172UL, 0x75d59b45UL,
+		0x7e89dc78UL, 0x7f4bb64fUL, 0x7d0d0816UL, 0x7ccf6221UL, 0x798074a4UL, 0x78421e93UL,
+		0x7a04a0caUL, 0x7bc6cafdUL, 0x6cbc2eb0UL, 0x6d7e4487UL, 0x6f38fadeUL, 0x6efa90e9UL,
+		0x6bb5866cUL, 0x6a77ec5bUL, 0x68315202UL, 0x69f33835UL, 0x62af7f08UL, 0x636d153fUL,
+		0x612bab66UL, 0x60e9c151UL, 0x65a6d7d4UL, 0x6464bde3UL, 0x662203baUL, 0x67e0698dUL,
+		0x48d7cb20UL, 0x4915a117UL, 0x4b531f4eUL, 0x4a917579UL, 0x4fde63fcUL, 0x4e1c09cbUL,
+		0x4c5ab792UL, 0x4d98dda5UL, 0x46c49a98UL, 0x4706f0afUL, 0x45404ef6UL, 0x448224c1UL,
+		0x41cd3244UL, 0x400f5873UL, 0x4249e62aUL, 0x438b8c1dUL, 0x54f16850UL, 0x55330267UL,
+		0x5775bc3eUL, 0x56b7d609UL, 0x53f8c08cUL, 0x523aaabbUL, 0x507c14e2UL, 0x51be7ed5UL,
+		0x5ae239e8UL, 0x5b2053dfUL, 0x5966ed86UL, 0x58a487b1UL, 0x5deb9134UL, 0x5c29fb03UL,
+		0x5e6f455aUL, 0x5fad2f6dUL, 0xe1351b80UL, 0xe0f771b7UL, 0xe2b1cfeeUL, 0xe373a5d9UL,
+		0xe63cb35cUL, 0xe7fed96bUL, 0xe5b86732UL, 0xe47a0d05UL, 0xef264a38UL, 0xeee4200fUL,
+		0xeca29e56UL, 0xed60f461UL, 0xe82fe2e4UL, 0xe9ed88d3UL, 0xebab368aUL, 0xea695cbdUL,
+		0xfd13b8f0UL, 0xfcd1d2c7UL, 0xfe976c9eUL, 0xff5506a9UL, 0xfa1a102cUL, 0xfbd87a1bUL,
+		0xf99ec442UL, 0xf85cae75UL, 0xf300e948UL, 0xf2c2837fUL, 0xf0843d26UL, 0xf1465711UL,
+		0xf4094194UL, 0xf5cb2ba3UL, 0xf78d95faUL, 0xf64fffcdUL, 0xd9785d60UL, 0xd8ba3757UL,
+		0xdafc890eUL, 0xdb3ee339UL, 0xde71f5bcUL, 0xdfb39f8bUL, 0xddf521d2UL, 0xdc374be5UL,
+		0xd76b0cd8UL, 0xd6a966efUL, 0xd4efd8b6UL, 0xd52db281UL, 0xd062a404UL, 0xd1a0ce33UL,
+		0xd3e6706aUL, 0xd2241a5dUL, 0xc55efe10UL, 0xc49c9427UL, 0xc6da2a7eUL, 0xc7184049UL,
+		0xc25756ccUL, 0xc3953cfbUL, 0xc1d382a2UL, 0xc011e895UL, 0xcb4dafa8UL, 0xca8fc59fUL,
+		0xc8c97bc6UL, 0xc90b11f1UL, 0xcc440774UL, 0xcd866d43UL, 0xcfc0d31aUL, 0xce02b92dUL,
+		0x91af9640UL, 0x906dfc77UL, 0x922b422eUL, 0x93e92819UL, 0x96a63e9cUL, 0x976454abUL,
+		0x9522eaf2UL, 0x94e080c5UL, 0x9fbcc7f8UL, 0x9e7eadcfUL, 0x9c381396UL, 0x9dfa79a1UL,
+		0x98b56f24UL, 0x99770513UL, 0x9b31bb4aUL, 0x9af3d17dUL, 0x8d893530UL, 0x8c4b5f07UL,
+		0x8e0de15eUL, 0x8fcf8b69UL, 0x8a809decUL, 0x8b42f7dbUL, 0x89044982UL, 0x88c623b5UL,
+		0x839a6488UL, 0x82580ebfUL, 0x801eb0e6UL, 0x81dcdad1UL, 0x8493cc54UL, 0x8551a663UL,
+		0x8717183aUL, 0x86d5720dUL, 0xa9e2d0a0UL, 0xa820ba97UL, 0xaa6604ceUL, 0xaba46ef9UL,
+		0xaeeb787cUL, 0xaf29124bUL, 0xad6fac12UL, 0xacadc625UL, 0xa7f18118UL, 0xa633eb2fUL,
+		0xa4755576UL, 0xa5b73f41UL, 0xa0f829c4UL, 0xa13a43f3UL, 0xa37cfdaaUL, 0xa2be979dUL,
+		0xb5c473d0UL, 0xb40619e7UL, 0xb640a7beUL, 0xb782cd89UL, 0xb2cddb0cUL, 0xb30fb13bUL,
+		0xb1490f62UL, 0xb08b6555UL, 0xbbd72268UL, 0xba15485fUL, 0xb853f606UL, 0xb9919c31UL,
+		0xbcde8ab4UL, 0xbd1ce083UL, 0xbf5a5edaUL, 0xbe9834edUL
+	},
+	{
+		0x00000000UL, 0xb8bc6765UL, 0xaa09c88bUL, 0x12b5afeeUL, 0x8f629757UL, 0x37def032UL,
+		0x256b5fdcUL, 0x9dd738b9UL, 0xc5b428efUL, 0x7d084f8aUL, 0x6fbde064UL, 0xd7018701UL,
+		0x4ad6bfb8UL, 0xf26ad8ddUL, 0xe0df7733UL, 0x58631056UL, 0x5019579fUL, 0xe8a530faUL,
+		0xfa109f14UL, 0x42acf871UL, 0xdf7bc0c8UL, 0x67c7a7adUL, 0x75720843UL, 0xcdce6f26UL,
+		0x95ad7f70UL, 0x2d111815UL, 0x3fa4b7fbUL, 0x8718d09eUL, 0x1acfe827UL, 0xa2738f42UL,
+		0xb0c620acUL, 0x087a47c9UL, 0xa032af3eUL, 0x188ec85bUL, 0x0a3b67b5UL, 0xb28700d0UL,
+		0x2f503869UL, 0x97ec5f0cUL, 0x8559f0e2UL, 0x3de59787UL, 0x658687d1UL, 0xdd3ae0b4UL,
+		0xcf8f4f5aUL, 0x7733283fUL, 0xeae41086UL, 0x525877e3UL, 0x40edd80dUL, 0xf851bf68UL,
+		0xf02bf8a1UL, 0x48979fc4UL, 0x5a22302aUL, 0xe29e574fUL, 0x7f496ff6UL, 0xc7f50893UL,
+		0xd540a77dUL, 0x6dfcc018UL, 0x359fd04eUL, 0x8d23b72bUL, 0x9f9618c5UL, 0x272a7fa0UL,
+		0xbafd4719UL, 0x0241207cUL, 0x10f48f92UL, 0xa848e8f7UL, 0x9b14583dUL, 0x23a83f58UL,
+		0x311d90b6UL, 0x89a1f7d3UL, 0x1476cf6aUL, 0xaccaa80fUL, 0xbe7f07e1UL, 0x06c36084UL,
+		0x5ea070d2UL, 0xe61c17b7UL, 0xf4a9b859UL, 0x4c15df3cUL, 0xd1c2e785UL, 0x697e80e0UL,
+		0x7bcb2f0eUL, 0xc377486bUL, 0xcb0d0fa2UL, 0x73b168c7UL, 0x6104c729UL, 0xd9b8a04cUL,
+		0x446f98f5UL, 0xfcd3ff90UL, 0xee66507eUL, 0x56da371bUL, 0x0eb9274dUL, 0xb6054028UL,
+		0xa4b0efc6UL, 0x1c0c88a3UL, 0x81dbb01aUL, 0x3967d77fUL, 0x2bd27891UL, 0x936e1ff4UL,
+		0x3b26f703UL, 0x839a9066UL, 0x912f3f88UL, 0x299358edUL, 0xb4446054UL, 0x0cf80731UL,
+		0x1e4da8dfUL, 0xa6f1cfbaUL, 0xfe92dfecUL, 0x462eb889UL, 0x549b1767UL, 0xec277002UL,
+		0x71f048bbUL, 0xc94c2fdeUL, 0xdbf98030UL, 0x6345e755UL, 0x6b3fa09cUL, 0xd383c7f9UL,
+		0xc1366817UL, 0x798a0f72UL, 0xe45d37cbUL, 0x5ce150aeUL, 0x4e54ff40UL, 0xf6e89825UL,
+		0xae8b8873UL, 0x1637ef16UL, 0x048240f8UL, 0xbc3e279dUL, 0x21e91f24UL, 0x99557841UL,
+		0x8be0d7afUL, 0x335cb0caUL, 0xed59b63bUL, 0x55e5d15eUL, 0x47507eb0UL, 0xffec19d5UL,
+		0x623b216cUL, 0xda874609UL, 0xc832e9e7UL, 0x708e8e82UL, 0x28ed9ed4UL, 0x9051f9b1UL,
+		0x82e4565fUL, 0x3a58313aUL, 0xa78f0983UL, 0x1f336ee6UL, 0x0d86c108UL, 0xb53aa66dUL,
+		0xbd40e1a4UL, 0x05fc86c1UL, 0x1749292fUL, 0xaff54e4aUL, 0x322276f3UL, 0x8a9e1196UL,
+		0x982bbe78UL, 0x2097d91dUL, 0x78f4c94bUL, 0xc048ae2eUL, 0xd2fd01c0UL, 0x6a4166a5UL,
+		0xf7965e1cUL, 0x4f2a3979UL, 0x5d9f9697UL, 0xe523f1f2UL, 0x4d6b1905UL, 0xf5d77e60UL,
+		0xe762d18eUL, 0x5fdeb6ebUL, 0xc2098e52UL, 0x7ab5e937UL, 0x680046d9UL, 0xd0bc21bcUL,
+		0x88df31eaUL, 0x3063568fUL, 0x22d6f961UL, 0x9a6a9e04UL, 0x07bda6bdUL, 0xbf01c1d8UL,
+		0xadb46e36UL, 0x15080953UL, 0x1d724e9aUL, 0xa5ce29ffUL, 0xb77b8611UL, 0x0fc7e174UL,
+		0x9210d9cdUL, 0x2aacbea8UL, 0x38191146UL, 0x80a57623UL, 0xd8c66675UL, 0x607a0110UL,
+		0x72cfaefeUL, 0xca73c99bUL, 0x57a4f122UL, 0xef189647UL, 0xfdad39a9UL, 0x45115eccUL,
+		0x764dee06UL, 0xcef18963UL, 0xdc44268dUL, 0x64f841e8UL, 0xf92f7951UL, 0x41931e34UL,
+		0x5326b1daUL, 0xeb9ad6bfUL, 0xb3f9c6e9UL, 0x0b45a18cUL, 0x19f00e62UL, 0xa14c6907UL,
+		0x3c9b51beUL, 0x842736dbUL, 0x96929935UL, 0x2e2efe50UL, 0x2654b999UL, 0x9ee8defcUL,
+		0x8c5d7112UL, 0x34e11677UL, 0xa9362eceUL, 0x118a49abUL, 0x033fe645UL, 0xbb838120UL,
+		0xe3e09176UL, 0x5b5cf613UL, 0x49e959fdUL, 0xf1553e98UL, 0x6c820621UL, 0xd43e6144UL,
+		0xc68bceaaUL, 0x7e37a9cfUL, 0xd67f4138UL, 0x6ec3265dUL, 0x7c7689b3UL, 0xc4caeed6UL,
+		0x591dd66fUL, 0xe1a1b10aUL, 0xf3141ee4UL, 0x4ba87981UL, 0x13cb69d7UL, 0xab770eb2UL,
+		0xb9c2a15cUL, 0x017ec639UL, 0x9ca9fe80UL, 0x241599e5UL, 0x36a0360bUL, 0x8e1c516eUL,
+		0x866616a7UL, 0x3eda71c2UL, 0x2c6fde2cUL, 0x94d3b949UL, 0x090481f0UL, 0xb1b8e695UL,
+		0xa30d497bUL, 0x1bb12e1eUL, 0x43d23e48UL, 0xfb6e592dUL, 0xe9dbf6c3UL, 0x516791a6UL,
+		0xccb0a91fUL, 0x740cce7aUL, 0x66b96194UL, 0xde0506f1UL
+	},
+	{
+		0x00000000UL, 0x3d6029b0UL, 0x7ac05360UL, 0x47a07ad0UL, 0xf580a6c0UL, 0xc8e08f70UL,
+		0x8f40f5a0UL, 0xb220dc10UL, 0x30704bc1UL, 0x0d106271UL, 0x4ab018a1UL, 0x77d03111UL,
+		0xc5f0ed01UL, 0xf890c4b1UL, 0xbf30be61UL, 0x825097d1UL, 0x60e09782UL, 0x5d80be32UL,
+		0x1a20c4e2UL, 0x2740ed52UL, 0x95603142UL, 0xa80018f2UL, 0xefa06222UL, 0xd2c04b92UL,
+		0x5090dc43UL, 0x6df0f5f3UL, 0x2a508f23UL, 0x1730a693UL, 0xa5107a83UL, 0x98705333UL,
+		0xdfd029e3UL, 0xe2b00053UL, 0xc1c12f04UL, 0xfca106b4UL, 0xbb017c64UL, 0x866155d4UL,
+		0x344189c4UL, 0x0921a074UL, 0x4e81daa4UL, 0x73e1f314UL, 0xf1b164c5UL, 0xccd14d75UL,
+		0x8b7137a5UL, 0xb6111e15UL, 0x0431c205UL, 0x3951ebb5UL, 0x7ef19165UL, 0x4391b8d5UL,
+		0xa121b886UL, 0x9c419136UL, 0xdbe1ebe6UL, 0xe681c256UL, 0x54a11e46UL, 0x69c137f6UL,
+		0x2e614d26UL, 0x13016496UL, 0x9151f347UL, 0xac31daf7UL, 0xeb91a027UL, 0xd6f18997UL,
+		0x64d15587UL, 0x59b17c37UL, 0x1e1106e7UL, 0x23712f57UL, 0x58f35849UL, 0x659371f9UL,
+		0x22330b29UL, 0x1f532299UL, 0xad73fe89UL, 0x9013d739UL, 0xd7b3ade9UL, 0xead38459UL,
+		0x68831388UL, 0x55e33a38UL, 0x124340e8UL, 0x2f236958UL, 0x9d03b548UL, 0xa0639cf8UL,
+		0xe7c3e628UL, 0xdaa3cf98UL, 0x3813cfcbUL, 0x0573e67bUL, 0x42d39cabUL, 0x7fb3b51bUL,
+		0xcd93690bUL, 0xf0f340bbUL, 0xb7533a6bUL, 0x8a3313dbUL, 0x0863840aUL, 0x3503adbaUL,
+		0x72a3d76aUL, 0x4fc3fedaUL, 0xfde322caUL, 0xc0830b7aUL, 0x872371aaUL, 0xba43581aUL,
+		0x9932774dUL, 0xa4525efdUL, 0xe3f2242dUL, 0xde920d9dUL, 0x6cb2d18dUL, 0x51d2f83dUL,
+		0x167282edUL, 0x2b12ab5dUL, 0xa9423c8cUL, 0x9422153cUL, 0xd3826fecUL, 0xeee2465cUL,
+		0x5cc29a4cUL, 0x61a2b3fcUL, 0x2602c92cUL, 0x1b62e09cUL, 0xf9d2e0cfUL, 0xc4b2c97fUL,
+		0x8312b3afUL, 0xbe729a1fUL, 0x0c52460fUL, 0x31326fbfUL, 0x7692156fUL, 0x4bf23cdfUL,
+		0xc9a2ab0eUL, 0xf4c282beUL, 0xb362f86eUL, 0x8e02d1deUL, 0x3c220dceUL, 0x0142247eUL,
+		0x46e25eaeUL, 0x7b82771eUL, 0xb1e6b092UL, 0x8c869922UL, 0xcb26e3f2UL, 0xf646ca42UL,
+		0x44661652UL, 0x79063fe2UL, 0x3ea64532UL, 0x03c66c82UL, 0x8196fb53UL, 0xbcf6d2e3UL,
+		0xfb56a833UL, 0xc6368183UL, 0x74165d93UL, 0x49767423UL, 0x0ed60ef3UL, 0x33b62743UL,
+		0xd1062710UL, 0xec660ea0UL, 0xabc67470UL, 0x96a65dc0UL, 0x248681d0UL, 0x19e6a860UL,
+		0x5e46d2b0UL, 0x6326fb00UL, 0xe1766cd1UL, 0xdc164561UL, 0x9bb63fb1UL, 0xa6d61601UL,
+		0x14f6ca11UL, 0x2996e3a1UL, 0x6e369971UL, 0x5356b0c1UL, 0x70279f96UL, 0x4d47b626UL,
+		0x0ae7ccf6UL, 0x3787e546UL, 0x85a73956UL, 0xb8c710e6UL, 0xff676a36UL, 0xc2074386UL,
+		0x4057d457UL, 0x7d37fde7UL, 0x3a978737UL, 0x07f7ae87UL, 0xb5d77297UL, 0x88b75b27UL,
+		0xcf1721f7UL, 0xf2770847UL, 0x10c70814UL, 0x2da721a4UL, 0x6a075b74UL, 0x576772c4UL,
+		0xe547aed4UL, 0xd8278764UL, 0x9f87fdb4UL, 0xa2e7d404UL, 0x20b743d5UL, 0x1dd76a65UL,
+		0x5a7710b5UL, 0x67173905UL, 0xd537e515UL, 0xe857cca5UL, 0xaff7b675UL, 0x92979fc5UL,
+		0xe915e8dbUL, 0xd475c16bUL, 0x93d5bbbbUL, 0xaeb5920bUL, 0x1c954e1bUL, 0x21f567abUL,
+		0x66551d7bUL, 0x5b3534cbUL, 0xd965a31aUL, 0xe4058aaaUL, 0xa3a5f07aUL, 0x9ec5d9caUL,
+		0x2ce505daUL, 0x11852c6aUL, 0x562556baUL, 0x6b457f0aUL, 0x89f57f59UL, 0xb49556e9UL,
+		0xf3352c39UL, 0xce550589UL, 0x7c75d999UL, 0x4115f029UL, 0x06b58af9UL, 0x3bd5a349UL,
+		0xb9853498UL, 0x84e51d28UL, 0xc34567f8UL, 0xfe254e48UL, 0x4c059258UL, 0x7165bbe8UL,
+		0x36c5c138UL, 0x0ba5e888UL, 0x28d4c7dfUL, 0x15b4ee6fUL, 0x521494bfUL, 0x6f74bd0fUL,
+		0xdd54611fUL, 0xe03448afUL, 0xa794327fUL, 0x9af41bcfUL, 0x18a48c1eUL, 0x25c4a5aeUL,
+		0x6264df7eUL, 0x5f04f6ceUL, 0xed242adeUL, 0xd044036eUL, 0x97e479beUL, 0xaa84500eUL,
+		0x4834505dUL, 0x755479edUL, 0x32f4033dUL, 0x0f942a8dUL, 0xbdb4f69dUL, 0x80d4df2dUL,
+		0xc774a5fdUL, 0xfa148c4dUL, 0x78441b9cUL, 0x4524322cUL, 0x028448fcUL, 0x3fe4614cUL,
+		0x8dc4bd5cUL, 0xb0a494ecUL, 0xf704ee3cUL, 0xca64c78cUL
+	},
+	{
+		0x00000000UL, 0xcb5cd3a5UL, 0x4dc8a10bUL, 0x869472aeUL, 0x9b914216UL, 0x50cd91b3UL,
+		0xd659e31dUL, 0x1d0530b8UL, 0xec53826dUL, 0x270f51c8UL, 0xa19b2366UL, 0x6ac7f0c3UL,
+		0x77c2c07bUL, 0xbc9e13deUL, 0x3a0a6170UL, 0xf156b2d5UL, 0x03d6029bUL, 0xc88ad13eUL,
+		0x4e1ea390UL, 0x85427035UL, 0x9847408dUL, 0x531b9328UL, 0xd58fe186UL, 0x1ed33223UL,
+		0xef8580f6UL, 0x24d95353UL, 0xa24d21fdUL, 0x6911f258UL, 0x7414c2e0UL, 0xbf481145UL,
+		0x39dc63ebUL, 0xf280b04eUL, 0x07ac0536UL, 0xccf0d693UL, 0x4a64a43dUL, 0x81387798UL,
+		0x9c3d4720UL, 0x57619485UL, 0xd1f5e62bUL, 0x1aa9358eUL, 0xebff875bUL, 0x20a354feUL,
+		0xa6372650UL, 0x6d6bf5f5UL, 0x706ec54dUL, 0xbb3216e8UL, 0x3da66446UL, 0xf6fab7e3UL,
+		0x047a07adUL, 0xcf26d408UL, 0x49b2a6a6UL, 0x82ee7503UL, 0x9feb45bbUL, 0x54b7961eUL,
+		0xd223e4b0UL, 0x197f3715UL, 0xe82985c0UL, 0x23755665UL, 0xa5e124cbUL, 0x6ebdf76eUL,
+		0x73b8c7d6UL, 0xb8e41473UL, 0x3e7066ddUL, 0xf52cb578UL, 0x0f580a6cUL, 0xc404d9c9UL,
+		0x4290ab67UL, 0x89cc78c2UL, 0x94c9487aUL, 0x5f959bdfUL, 0xd901e971UL, 0x125d3ad4UL,
+		0xe30b8801UL, 0x28575ba4UL, 0xaec3290aUL, 0x659ffaafUL, 0x789aca17UL, 0xb3c619b2UL,
+		0x35526b1cUL, 0xfe0eb8b9UL, 0x0c8e08f7UL, 0xc7d2db52UL, 0x4146a9fcUL, 0x8a1a7a59UL,
+		0x971f4ae1UL, 0x5c439944UL, 0xdad7ebeaUL, 0x118b384fUL, 0xe0dd8a9aUL, 0x2b81593fUL,
+		0xad152b91UL, 0x6649f834UL, 0x7b4cc88cUL, 0xb0101b29UL, 0x36846987UL, 0xfdd8ba22UL,
+		0x08f40f5aUL, 0xc3a8dcffUL, 0x453cae51UL, 0x8e607df4UL, 0x93654d4cUL, 0x58399ee9UL,
+		0xdeadec47UL, 0x15f13fe2UL, 0xe4a78d37UL, 0x2ffb5e92UL, 0xa96f2c3cUL, 0x6233ff99UL,
+		0x7f36cf21UL, 0xb46a1c84UL, 0x32fe6e2aUL, 0xf9a2bd8fUL, 0x0b220dc1UL, 0xc07ede64UL,
+		0x46eaaccaUL, 0x8db67f6fUL, 0x90b34fd7UL, 0x5bef9c72UL, 0xdd7beedcUL, 0x16273d79UL,
+		0xe7718facUL, 0x2c2d5c09UL, 0xaab92ea7UL, 0x61e5fd02UL, 0x7ce0cdbaUL, 0xb7bc1e1fUL,
+		0x31286cb1UL, 0xfa74bf14UL, 0x1eb014d8UL, 0xd5ecc77dUL, 0x5378b5d3UL, 0x98246676UL,
+		0x852156ceUL, 0x4e7d856bUL, 0xc8e9f7c5UL, 0x03b52460UL, 0xf2e396b5UL, 0x39bf4510UL,
+		0xbf2b37beUL, 0x7477e41bUL, 0x6972d4a3UL, 0xa22e0706UL, 0x24ba75a8UL, 0xefe6a60dUL,
+		0x1d661643UL, 0xd63ac5e6UL, 0x50aeb748UL, 0x9bf264edUL, 0x86f75455UL, 0x4dab87f0UL,
+		0xcb3ff55eUL, 0x006326fbUL, 0xf135942eUL, 0x3a69478bUL, 0xbcfd3525UL, 0x77a1e680UL,
+		0x6aa4d638UL, 0xa1f8059dUL, 0x276c7733UL, 0xec30a496UL, 0x191c11eeUL, 0xd240c24bUL,
+		0x54d4b0e5UL, 0x9f886340UL, 0x828d53f8UL, 0x49d1805dUL, 0xcf45f2f3UL, 0x04192156UL,
+		0xf54f9383UL, 0x3e134026UL, 0xb8873288UL, 0x73dbe12dUL, 0x6eded195UL, 0xa5820230UL,
+		0x2316709eUL, 0xe84aa33bUL, 0x1aca1375UL, 0xd196c0d0UL, 0x5702b27eUL, 0x9c5e61dbUL,
+		0x815b5163UL, 0x4a0782c6UL, 0xcc93f068UL, 0x07cf23cdUL, 0xf6999118UL, 0x3dc542bdUL,
+		0xbb513013UL, 0x700de3b6UL, 0x6d08d30eUL, 0xa65400abUL, 0x20c07205UL, 0xeb9ca1a0UL,
+		0x11e81eb4UL, 0xdab4cd11UL, 0x5c20bfbfUL, 0x977c6c1aUL, 0x8a795ca2UL, 0x41258f07UL,
+		0xc7b1fda9UL, 0x0ced2e0cUL, 0xfdbb9cd9UL, 0x36e74f7cUL, 0xb0733dd2UL, 0x7b2fee77UL,
+		0x662adecfUL, 0xad760d6aUL, 0x2be27fc4UL, 0xe0beac61UL, 0x123e1c2fUL, 0xd962cf8aUL,
+		0x5ff6bd24UL, 0x94aa6e81UL, 0x89af5e39UL, 0x42f38d9cUL, 0xc467ff32UL, 0x0f3b2c97UL,
+		0xfe6d9e42UL, 0x35314de7UL, 0xb3a53f49UL, 0x78f9ececUL, 0x65fcdc54UL, 0xaea00ff1UL,
+		0x28347d5fUL, 0xe368aefaUL, 0x16441b82UL, 0xdd18c827UL, 0x5b8cba89UL, 0x90d0692cUL,
+		0x8dd55994UL, 0x46898a31UL, 0xc01df89fUL, 0x0b412b3aUL, 0xfa1799efUL, 0x314b4a4aUL,
+		0xb7df38e4UL, 0x7c83eb41UL, 0x6186dbf9UL, 0xaada085cUL, 0x2c4e7af2UL, 0xe712a957UL,
+		0x15921919UL, 0xdececabcUL, 0x585ab812UL, 0x93066bb7UL, 0x8e035b0fUL, 0x455f88aaUL,
+		0xc3cbfa04UL, 0x089729a1UL, 0xf9c19b74UL, 0x329d48d1UL, 0xb4093a7fUL, 0x7f55e9daUL,
+		0x6250d962UL, 0xa90c0ac7UL, 0x2f987869UL, 0xe4c4abccUL
+	},
+	{
+		0x00000000UL, 0xa6770bb4UL, 0x979f1129UL, 0x31e81a9dUL, 0xf44f2413UL, 0x52382fa7UL,
+		0x63d0353aUL, 0xc5a73e8eUL, 0x33ef4e67UL, 0x959845d3UL, 0xa4705f4eUL, 0x020754faUL,
+		0xc7a06a74UL, 0x61d761c0UL, 0x503f7b5dUL, 0xf64870e9UL, 0x67de9cceUL, 0xc1a9977aUL,
+		0xf0418de7UL, 0x56368653UL, 0x9391b8ddUL, 0x35e6b369UL, 0x040ea9f4UL, 0xa279a240UL,
+		0x5431d2a9UL, 0xf246d91dUL, 0xc3aec380UL, 0x65d9c834UL, 0xa07ef6baUL, 0x0609fd0eUL,
+		0x37e1e793UL, 0x9196ec27UL, 0xcfbd399cUL, 0x69ca3228UL, 0x582228b5UL, 0xfe552301UL,
+		0x3bf21d8fUL, 0x9d85163bUL, 0xac6d0ca6UL, 0x0a1a0712UL, 0xfc5277fbUL, 0x5a257c4fUL,
+		0x6bcd66d2UL, 0xcdba6d66UL, 0x081d53e8UL, 0xae6a585cUL, 0x9f8242c1UL, 0x39f54975UL,
+		0xa863a552UL, 0x0e14aee6UL, 0x3ffcb47bUL, 0x998bbfcfUL, 0x5c2c8141UL, 0xfa5b8af5UL,
+		0xcbb39068UL, 0x6dc49bdcUL, 0x9b8ceb35UL, 0x3dfbe081UL, 0x0c13fa1cUL, 0xaa64f1a8UL,
+		0x6fc3cf26UL, 0xc9b4c492UL, 0xf85cde0fUL, 0x5e2bd5bbUL, 0x440b7579UL, 0xe27c7ecdUL,
+		0xd3946450UL, 0x75e36fe4UL, 0xb044516aUL, 0x16335adeUL, 0x27db4043UL, 0x81ac4bf7UL,
+		0x77e43b1eUL, 0xd19330aaUL, 0xe07b2a37UL, 0x460c2183UL, 0x83ab1f0dUL, 0x25dc14b9UL,
+		0x14340e24UL, 0xb2430590UL, 0x23d5e9b7UL, 0x85a2e203UL, 0xb44af89eUL, 0x123df32aUL,
+		0xd79acda4UL, 0x71edc610UL, 0x4005dc8dUL, 0xe672d739UL, 0x103aa7d0UL, 0xb64dac64UL,
+		0x87a5b6f9UL, 0x21d2bd4dUL, 0xe47583c3UL, 0x42028877UL, 0x73ea92eaUL, 0xd59d995eUL,
+		0x8bb64ce5UL, 0x2dc14751UL, 0x1c295dccUL, 0xba5e5678UL, 0x7ff968f6UL, 0xd98e6342UL,
+		0xe86679dfUL, 0x4e11726bUL, 0xb8590282UL, 0x1e2e0936UL, 0x2fc613abUL, 0x89b1181fUL,
+		0x4c162691UL, 0xea612d25UL, 0xdb8937b8UL, 0x7dfe3c0cUL, 0xec68d02bUL, 0x4a1fdb9fUL,
+		0x7bf7c102UL, 0xdd80cab6UL, 0x1827f438UL, 0xbe50ff8cUL, 0x8fb8e511UL, 0x29cfeea5UL,
+		0xdf879e4cUL, 0x79f095f8UL, 0x48188f65UL, 0xee6f84d1UL, 0x2bc8ba5fUL, 0x8dbfb1ebUL,
+		0xbc57ab76UL, 0x1a20a0c2UL, 0x8816eaf2UL, 0x2e61e146UL, 0x1f89fbdbUL, 0xb9fef06fUL,
+		0x7c59cee1UL, 0xda2ec555UL, 0xebc6dfc8UL, 0x4db1d47cUL, 0xbbf9a495UL, 0x1d8eaf21UL,
+		0x2c66b5bcUL, 0x8a11be08UL, 0x4fb68086UL, 0xe9c18b32UL, 0xd82991afUL, 0x7e5e9a1bUL,
+		0xefc8763cUL, 0x49bf7d88UL, 0x78576715UL, 0xde206ca1UL, 0x1b87522fUL, 0xbdf0599bUL,
+		0x8c184306UL, 0x2a6f48b2UL, 0xdc27385bUL, 0x7a5033efUL, 0x4bb82972UL, 0xedcf22c6UL,
+		0x28681c48UL, 0x8e1f17fcUL, 0xbff70d61UL, 0x198006d5UL, 0x47abd36eUL, 0xe1dcd8daUL,
+		0xd034c247UL, 0x7643c9f3UL, 0xb3e4f77dUL, 0x1593fcc9UL, 0x247be654UL, 0x820cede0UL,
+		0x74449d09UL, 0xd23396bdUL, 0xe3db8c20UL, 0x45ac8794UL, 0x800bb91aUL, 0x267cb2aeUL,
+		0x1794a833UL, 0xb1e3a387UL, 0x20754fa0UL, 0x86024414UL, 0xb7ea5e89UL, 0x119d553dUL,
+		0xd43a6bb3UL, 0x724d6007UL, 0x43a57a9aUL, 0xe5d2712eUL, 0x139a01c7UL, 0xb5ed0a73UL,
+		0x840510eeUL, 0x22721b5aUL, 0xe7d525d4UL, 0x41a22e60UL, 0x704a34fdUL, 0xd63d3f49UL,
+		0xcc1d9f8bUL, 0x6a6a943fUL, 0x5b828ea2UL, 0xfdf58516UL, 0x3852bb98UL, 0x9e25b02cUL,
+		0xafcdaab1UL, 0x09baa105UL, 0xfff2d1ecUL, 0x5985da58UL, 0x686dc0c5UL, 0xce1acb71UL,
+		0x0bbdf5ffUL, 0xadcafe4bUL, 0x9c22e4d6UL, 0x3a55ef62UL, 0xabc30345UL, 0x0db408f1UL,
+		0x3c5c126cUL, 0x9a2b19d8UL, 0x5f8c2756UL, 0xf9fb2ce2UL, 0xc813367fUL, 0x6e643dcbUL,
+		0x982c4d22UL, 0x3e5b4696UL, 0x0fb35c0bUL, 0xa9c457bfUL, 0x6c636931UL, 0xca146285UL,
+		0xfbfc7818UL, 0x5d8b73acUL, 0x03a0a617UL, 0xa5d7ada3UL, 0x943fb73eUL, 0x3248bc8aUL,
+		0xf7ef8204UL, 0x519889b0UL, 0x6070932dUL, 0xc6079899UL, 0x304fe870UL, 0x9638e3c4UL,
+		0xa7d0f959UL, 0x01a7f2edUL, 0xc400cc63UL, 0x6277c7d7UL, 0x539fdd4aUL, 0xf5e8d6feUL,
+		0x647e3ad9UL, 0xc209316dUL, 0xf3e12bf0UL, 0x55962044UL, 0x90311ecaUL, 0x3646157eUL,
+		0x07ae0fe3UL, 0xa1d90457UL, 0x579174beUL, 0xf1e67f0aUL, 0xc00e6597UL, 0x66796e23UL,
+		0xa3de50adUL, 0x05a95b19UL, 0x34414184UL, 0x92364a30UL
+	},
+	{
+		0x00000000UL, 0xccaa009eUL, 0x4225077dUL, 0x8e8f07e3UL, 0x844a0efaUL, 0x48e00e64UL,
+		0xc66f0987UL, 0x0ac50919UL, 0xd3e51bb5UL, 0x1f4f1b2bUL, 0x91c01cc8UL, 0x5d6a1c56UL,
+		0x57af154fUL, 0x9b0515d1UL, 0x158a1232UL, 0xd92012acUL, 0x7cbb312bUL, 0xb01131b5UL,
+		0x3e9e3656UL, 0xf23436c8UL, 0xf8f13fd1UL, 0x345b3f4fUL, 0xbad438acUL, 0x767e3832UL,
+		0xaf5e2a9eUL, 0x63f42a00UL, 0xed7b2de3UL, 0x21d12d7dUL, 0x2b142464UL, 0xe7be24faUL,
+		0x69312319UL, 0xa59b2387UL, 0xf9766256UL, 0x35dc62c8UL, 0xbb53652bUL, 0x77f965b5UL,
+		0x7d3c6cacUL, 0xb1966c32UL, 0x3f196bd1UL, 0xf3b36b4fUL, 0x2a9379e3UL, 0xe639797dUL,
+		0x68b67e9eUL, 0xa41c7e00UL, 0xaed97719UL, 0x62737787UL, 0xecfc7064UL, 0x205670faUL,
+		0x85cd537dUL, 0x496753e3UL, 0xc7e85400UL, 0x0b42549eUL, 0x01875d87UL, 0xcd2d5d19UL,
+		0x43a25afaUL, 0x8f085a64UL, 0x562848c8UL, 0x9a824856UL, 0x140d4fb5UL, 0xd8a74f2bUL,
+		0xd2624632UL, 0x1ec846acUL, 0x9047414fUL, 0x5ced41d1UL, 0x299dc2edUL, 0xe537c273UL,
+		0x6bb8c590UL, 0xa712c50eUL, 0xadd7cc17UL, 0x617dcc89UL, 0xeff2cb6aUL, 0x2358cbf4UL,
+		0xfa78d958UL, 0x36d2d9c6UL, 0xb85dde25UL, 0x74f7debbUL, 0x7e32d7a2UL, 0xb298d73cUL,
+		0x3c17d0dfUL, 0xf0bdd041UL, 0x5526f3c6UL, 0x998cf358UL, 0x1703f4bbUL, 0xdba9f425UL,
+		0xd16cfd3cUL, 0x1dc6fda2UL, 0x9349fa41UL, 0x5fe3fadfUL, 0x86c3e873UL, 0x4a69e8edUL,
+		0xc4e6ef0eUL, 0x084cef90UL, 0x0289e689UL, 0xce23e617UL, 0x40ace1f4UL, 0x8c06e16aUL,
+		0xd0eba0bbUL, 0x1c41a025UL, 0x92cea7c6UL, 0x5e64a758UL, 0x54a1ae41UL, 0x980baedfUL,
+		0x1684a93cUL, 0xda2ea9a2UL, 0x030ebb0eUL, 0xcfa4bb90UL, 0x412bbc73UL, 0x8d81bcedUL,
+		0x8744b5f4UL, 0x4beeb56aUL, 0xc561b289UL, 0x09cbb217UL, 0xac509190UL, 0x60fa910eUL,
+		0xee7596edUL, 0x22df9673UL, 0x281a9f6aUL, 0xe4b09ff4UL, 0x6a3f9817UL, 0xa6959889UL,
+		0x7fb58a25UL, 0xb31f8abbUL, 0x3d908d58UL, 0xf13a8dc6UL, 0xfbff84dfUL, 0x37558441UL,
+		0xb9da83a2UL, 0x7570833cUL, 0x533b85daUL, 0x9f918544UL, 0x111e82a7UL, 0xddb48239UL,
+		0xd7718b20UL, 0x1bdb8bbeUL, 0x95548c5dUL, 0x59fe8cc3UL, 0x80de9e6fUL, 0x4c749ef1UL,
+		0xc2fb9912UL, 0x0e51998cUL, 0x04949095UL, 0xc83e900bUL, 0x46b197e8UL, 0x8a1b9776UL,
+		0x2f80b4f1UL, 0xe32ab46fUL, 0x6da5b38cUL, 0xa10fb312UL, 0xabcaba0bUL, 0x6760ba95UL,
+		0xe9efbd76UL, 0x2545bde8UL, 0xfc65af44UL, 0x30cfafdaUL, 0xbe40a839UL, 0x72eaa8a7UL,
+		0x782fa1beUL, 0xb485a120UL, 0x3a0aa6c3UL, 0xf6a0a65dUL, 0xaa4de78cUL, 0x66e7e712UL,
+		0xe868e0f1UL, 0x24c2e06fUL, 0x2e07e976UL, 0xe2ade9e8UL, 0x6c22ee0bUL, 0xa088ee95UL,
+		0x79a8fc39UL, 0xb502fca7UL, 0x3b8dfb44UL, 0xf727fbdaUL, 0xfde2f2c3UL, 0x3148f25dUL,
+		0xbfc7f5beUL, 0x736df520UL, 0xd6f6d6a7UL, 0x1a5cd639UL, 0x94d3d1daUL, 0x5879d144UL,
+		0x52bcd85dUL, 0x9e16d8c3UL, 0x1099df20UL, 0xdc33dfbeUL, 0x0513cd12UL, 0xc9b9cd8cUL,
+		0x4736ca6fUL, 0x8b9ccaf1UL, 0x8159c3e8UL, 0x4df3c376UL, 0xc37cc495UL, 0x0fd6c40bUL,
+		0x7aa64737UL, 0xb60c47a9UL, 0x3883404aUL, 0xf42940d4UL, 0xfeec49cdUL, 0x32464953UL,
+		0xbcc94eb0UL, 0x70634e2eUL, 0xa9435c82UL, 0x65e95c1cUL, 0xeb665bffUL, 0x27cc5b61UL,
+		0x2d095278UL, 0xe1a352e6UL, 0x6f2c5505UL, 0xa386559bUL, 0x061d761cUL, 0xcab77682UL,
+		0x44387161UL, 0x889271ffUL, 0x825778e6UL, 0x4efd7878UL, 0xc0727f9bUL, 0x0cd87f05UL,
+		0xd5f86da9UL, 0x19526d37UL, 0x97dd6ad4UL, 0x5b776a4aUL, 0x51b26353UL, 0x9d1863cdUL,
+		0x1397642eUL, 0xdf3d64b0UL, 0x83d02561UL, 0x4f7a25ffUL, 0xc1f5221cUL, 0x0d5f2282UL,
+		0x079a2b9bUL, 0xcb302b05UL, 0x45bf2ce6UL, 0x89152c78UL, 0x50353ed4UL, 0x9c9f3e4aUL,
+		0x121039a9UL, 0xdeba3937UL, 0xd47f302eUL, 0x18d530b0UL, 0x965a3753UL, 0x5af037cdUL,
+		0xff6b144aUL, 0x33c114d4UL, 0xbd4e1337UL, 0x71e413a9UL, 0x7b211ab0UL, 0xb78b1a2eUL,
+		0x39041dcdUL, 0xf5ae1d53UL, 0x2c8e0fffUL, 0xe0240f61UL, 0x6eab0882UL, 0xa201081cUL,
+		0xa8c40105UL, 0x646e019bUL, 0xeae10678UL, 0x264b06e6UL
+	}
+};
+#endif  /* LOWZIP_FAST_CRC32 */
+
+/*
+ *  CRC-32
+ */
+
+#if defined(LOWZIP_FAST_CRC32)
+/* Update a (pre-inverted) CRC-32 register over [p_start,p_end[ using
+ * slicing-by-8: eight input bytes per step using eight tables.  Bytes are
+ * combined explicitly so that this works regardless of alignment and
+ * endianness.
+ */
+static unsigned int lowzip_crc32_slice8(unsigned int crc, const unsigned char *p_start, const unsigned char *p_end) {
+	unsigned int hi;
+
+	while (p_end - p_start >= 8) {
+		crc ^= (unsigned int) p_start[0] | ((unsigned int) p_start[1] << 8U) |
+		       ((unsigned int) p_start[2] << 16U) | ((unsigned int) p_start[3] << 24U);
+		hi = (unsigned int) p_start[4] | ((unsigned int) p_start[5] << 8U) |
+		     ((unsigned int) p_start[6] << 16U) | ((unsigned int) p_start[7] << 24U);
+		crc = lowzip_crc32_table[7][crc & 0xffU] ^
+		      lowzip_crc32_table[6][(crc >> 8U) & 0xffU] ^
+		      lowzip_crc32_table[5][(crc >> 16U) & 0xffU] ^
+		      lowzip_crc32_table[4][crc >> 24U] ^
+		      lowzip_crc32_table[3][hi & 0xffU] ^
+		      lowzip_crc32_table[2][(hi >> 8U) & 0xffU] ^
+		      lowzip_crc32_table[1][(hi >> 16U) & 0xffU] ^
+		      lowzip_crc32_table[0][hi >> 24U];
+		p_start += 8;
+	}
+	while (p_start < p_end) {
+		crc = (crc >> 8U) ^ lowzip_crc32_table[0][(crc ^ (unsigned int) (*p_start++)) & 0xffU];
+	}
+	return crc;
+}
+#endif  /* LOWZIP_FAST_CRC32 */
+
+#if defined(LOWZIP_CRC32_CLMUL)
+/* Check for SSE2 and PCLMULQDQ support using CPUID, cached so that CPUID
+ * runs once.  States may be used from several threads, so the cache is
+ * accessed atomically.
+ */
+static int lowzip_crc32_have_clmul(void) {
+	static int have_clmul = -1;
+	unsigned int eax, ebx, ecx, edx;
+	int res;
+
+	res = __atomic_load_n(&have_clmul, __ATOMIC_RELAXED);
+	if (res < 0) {
+		res = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+			res = ((ecx & bit_PCLMUL) && (edx & bit_SSE2)) ? 1 : 0;
+		}
+		__atomic_store_n(&have_clmul, res, __ATOMIC_RELAXED);
+	}
+	return res;
+}
+
+/* Update a (pre-inverted) CRC-32 register using carry-less multiplication,
+ * see Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction".  Four 128-bit lanes are folded 64 bytes at a time, then
+ * folded into one lane, reduced to 64 bits and finally to 32 bits with a
+ * Barrett reduction.  Constants are for the bit-reflected polynomial
+ * 0xedb88320.  Input length must be a multiple of 16 and at least 64.
+ */
+__attribute__((target("sse2,pclmul")))
+static unsigned int lowzip_crc32_clmul(unsigned int crc, const unsigned char *p_start, const unsigned char *p_end) {
+	__m128i k1k2, k3k4, k5, poly, mask;
+	__m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+	k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+	k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+	k5 = _mm_set_epi64x(0, 0x0163cd6124LL);
+	poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+	mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+	x1 = _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+	p_start += 64;
+
+	while (p_end - p_start >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *) (const void *) (p_start + 0x30)));
+		p_start += 64;
+	}
+
+	/* Fold four lanes into one, then any remaining 16-byte blocks. */
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+	while (p_end - p_start >= 16) {
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *) (const void *) p_start)), x5);
+		p_start += 16;
+	}
+
+	/* Fold 128 bits to 64 bits. */
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask);
+	x1 = _mm_clmulepi64_si128(x1, k5, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits. */
+	x2 = _mm_and_si128(x1, mask);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (unsigned int) _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+#endif  /* LOWZIP_CRC32_CLMUL */
+
+/* Update a (pre-inverted) CRC-32 register over [p_start,p_end[.  The ZIP
+ * CRC-32 is the final register value inverted.
+ */
+static unsigned int lowzip_crc32_update(unsigned int crc, const unsigned char *p_start, const unsigned char *p_end) {
+#if defined(LOWZIP_FAST_CRC32)
+#if defined(LOWZIP_CRC32_CLMUL)
+	const unsigned char *p;
+
+	if (p_end - p_start >= 64 && lowzip_crc32_have_clmul()) {
+		p = p_start + ((p_end - p_start) & ~((ptrdiff_t) 15));
+		crc = lowzip_crc32_clmul(crc, p_start, p);
+		p_start = p;
+	}
+#endif
+	crc = lowzip_crc32_slice8(crc, p_start, p_end);
+#else
+	int i;
+
+	while (p_start < p_end) {
+		crc ^= (unsigned int) (*p_start++);
+		for (i = 0; i < 8; i++) {
+			if (crc & 0x01UL) {
+				crc = (crc >> 1U) ^ 0xedb88320UL;
+			} else {
+				crc = (crc >> 1U);
+			}
+		}
+	}
+#endif
+
+	return crc;
+}
+
+/* Compute CRC-32 incrementally while producing output: update the running
+ * CRC-32 over output written since the previous call.  Called after each
+ * inflate block so that the data is likely still in cache, instead of
+ * rescanning the whole output afterwards.  Does nothing unless enabled by
+ * setting st->crc_next (lowzip_get_data() does so).
+ */
+static void lowzip_update_output_crc(lowzip_state *st) {
+	if (st->crc_next) {
+		st->crc32 = lowzip_crc32_update(st->crc32, st->crc_next, st->output_next);
+		st->crc_next = st->output_next;
+	}
+}
+
 /*
  *  Read/write helpers
  */
 
+#if defined(LOWZIP_RANDOM_ACCESS)
+/* Copy the part of output chunk [p,p+len[ which falls into the range being
+ * read by lowzip_read_range().  Once the range is complete, decoding is
+ * stopped by flagging an error which lowzip_read_range() then clears.
+ */
+static void lowzip_copy_output_range(lowzip_state *st, const unsigned char *p, unsigned int len) {
+	if (st->range_skip >= len) {
+		st->range_skip -= len;
+		return;
+	}
+	p += st->range_skip;
+	len -= st->range_skip;
+	st->range_skip = 0;
+	if (len > st->range_left) {
+		len = st->range_left;
+	}
+	memcpy((void *) st->range_next, (const void *) p, len);
+	st->range_next += len;
+	st->range_left -= len;
+	if (st->range_left == 0) {
+		st->have_error = 1;
+	}
+}
+#endif  /* LOWZIP_RANDOM_ACCESS */
+
+#if defined(LOWZIP_STREAMING)
+/* Streaming output: pass output produced since the previous flush to the
+ * write callback and slide the window so that only the last 32kB, needed
+ * for back-references, remain at the start of the output buffer.  The
+ * running CRC-32 is updated before the data is moved.
+ */
+static void lowzip_flush_output(lowzip_state *st) {
+	unsigned int len;
+
+	lowzip_update_output_crc(st);
+
+	len = (unsigned int) (st->output_next - st->flush_next);
+	if (len > 0) {
+#if defined(LOWZIP_RANDOM_ACCESS)
+		if (st->range_next) {
+			lowzip_copy_output_range(st, st->flush_next, len);
+		}
+#endif
+		if (st->write_callback(st->udata, st->flush_next, len) != 0) {
+			st->have_error = 1;
+			return;
+		}
+		st->output_flushed += len;
+	}
+
+	if (st->output_next - st->output_start > 32768) {
+		memmove((void *) st->output_start, (const void *) (st->output_next - 32768), 32768);
+		st->output_next = st->output_start + 32768;
+	}
+	st->flush_next = st->output_next;
+	if (st->crc_next) {
+		st->crc_next = st->output_next;
+	}
+}
+#endif  /* LOWZIP_STREAMING */
+
+/* Ensure there's room for 'len' bytes of output, at most 258 bytes (maximum
+ * back-reference length) in streaming mode.  Flushes output if necessary in
+ * streaming mode.  Returns zero and sets st->have_error if there's no room.
+ */
+static int lowzip_reserve_output(lowzip_state *st, unsigned int len) {
+	if ((ptrdiff_t) len > (ptrdiff_t) (st->output_end - st->output_next)) {
+#if defined(LOWZIP_STREAMING)
+		/* Never flush after an error: the output pointer may still be
+		 * rolled back when resuming.
+		 */
+		if (!st->write_callback || st->have_error) {
+			st->have_error = 1;
+			return 0;
+		}
+		lowzip_flush_output(st);
+		if (st->have_error) {
+			return 0;
+		}
+#else
+		st->have_error = 1;
+		return 0;
+#endif
+	}
+	return 1;
+}
+
 /* Write an output byte.  If end of output encountered, flag an error and
  * do nothing.
  */
 static void lowzip_write_byte(lowzip_state *st, unsigned char ch) {
-	if (st->output_next >= st->output_end) {
-		st->have_error = 1;
-	} else {
+	if (lowzip_reserve_output(st, 1)) {
 		*st->output_next++ = ch;
 	}
 }
 
+/* Prepare output state for lowzip_get_data() or lowzip_inflate_raw(). */
+static void lowzip_init_output(lowzip_state *st) {
+	st->flush_next = st->output_next;
+#if defined(LOWZIP_STREAMING)
+	st->output_flushed = 0;
+	if (st->write_callback &&
+	    (ptrdiff_t) (st->output_end - st->output_start) < (ptrdiff_t) LOWZIP_STREAM_OUTPUT_MIN) {
+		st->have_error = 1;
+	}
+#endif
+}
+
+/* Length of output produced since lowzip_init_output(), including output
+ * already passed to the write callback.
+ */
+static unsigned int lowzip_output_length(lowzip_state *st) {
+#if defined(LOWZIP_STREAMING)
+	return st->output_flushed + (unsigned int) (st->output_next - st->flush_next);
+#else
+	return (unsigned int) (st->output_next - st->flush_next);
+#endif
+}
+
+/* Get a pointer to input bytes [offset,offset+length[ if they're all in the
+ * current input window, otherwise return NULL.
+ */
+static const unsigned char *lowzip_input_span(lowzip_state *st, unsigned int offset, unsigned int length) {
+	unsigned int t;
+
+	/* Unsigned wrap handles offset < st->input_offset. */
+	t = offset - st->input_offset;
+	if (t < st->input_length && st->input_length - t >= length) {
+		return st->input_data + t;
+	}
+	return NULL;
+}
+
+/* Read a single input byte at given offset, returns 0x100 if out of bounds.
+ * With a span callback reads are served from st->input_buf which is refilled
+ * starting from the requested offset, so forward scanning is cheap.
+ */
+static unsigned int lowzip_read_input(lowzip_state *st, unsigned int offset) {
+	unsigned int t;
+	unsigned int start;
+
+	/* Unsigned wrap handles offset < st->input_offset. */
+	t = offset - st->input_offset;
+	if (t < st->input_length) {
+		return st->input_data[t];
+	}
+
+	if (st->read_span_callback == NULL) {
+		if (st->read_callback == NULL) {
+			/* In-memory archive, out of bounds. */
+			return 0x100U;
+		}
+		return st->read_callback(st->udata, offset);
+	}
+
+	/* When scanning backwards (end of central directory search), fill
+	 * the buffer so that it ends just after the requested 4-byte field.
+	 */
+	start = offset;
+	if (offset < st->input_offset) {
+		start = offset > sizeof(st->input_buf) - 4 ? offset - (sizeof(st->input_buf) - 4) : 0;
+	}
+
+	t = st->read_span_callback(st->udata, start, st->input_buf, sizeof(st->input_buf));
+	if (t > sizeof(st->input_buf)) {
+		t = 0;  /* Broken callback, ignore data. */
+	}
+	st->input_data = st->input_buf;
+	st->input_offset = start;
+	st->input_length = t;
+	t = offset - start;
+	if (t >= st->input_length) {
+		return 0x100U;
+	}
+	return st->input_buf[t];
+}
+
 /* Read an N-byte little-endian value at given offset. */
 static unsigned int lowzip_read_little_endian(lowzip_state *st, unsigned int offset, unsigned int count) {
 	unsigned int res;
 	unsigned int t;
+	unsigned int shift;
+	const unsigned char *p;
 
 	res = 0;
-	while (count-- > 0) {
-		t = st->read_callback(st->udata, offset + count);
+	p = lowzip_input_span(st, offset, count);
+	if (p) {
+		while (count-- > 0) {
+			res = (res << 8U) + p[count];
+		}
+		return res;
+	}
+	for (shift = 0; count-- > 0; shift += 8) {
+		t = lowzip_read_input(st, offset++);
 		if (t & 0x100U) {
 			st->have_error = 1;
 			res = 0;
 			break;
 		} else {
-			res = (res << 8U) + t;
+			res += t << shift;
 		}
 	}
 	return res;
@@ -174,6 +1052,38 @@ static unsigned int lowzip_read1(lowzip_state *st, unsigned int offset) {
 	return lowzip_read_little_endian(st, offset, 1);
 }
 
+/* Copy input bytes [offset,offset+length[ to 'buf': from the input window,
+ * using the span read callback, or byte by byte.  Sets st->have_error if
+ * the input isn't available.
+ */
+static void lowzip_copy_input(lowzip_state *st, unsigned int offset, unsigned char *buf, unsigned int length) {
+	const unsigned char *p;
+	unsigned int n;
+
+	while (length > 0) {
+		p = lowzip_input_span(st, offset, length);
+		if (p) {
+			memcpy((void *) buf, (const void *) p, length);
+			return;
+		} else if (st->read_span_callback) {
+			n = st->read_span_callback(st->udata, offset, buf, length);
+			if (n == 0 || n > length) {
+				st->have_error = 1;
+				return;
+			}
+		} else {
+			n = 1;
+			*buf = (unsigned char) lowzip_read1(st, offset);
+			if (st->have_error) {
+				return;
+			}
+		}
+		buf += n;
+		offset += n;
+		length -= n;
+	}
+}
+
 /* Read next input byte using st->read_offset.  When out of input, feed in
  * zeroes and flag an error.  The zeroes are processed as if they were in the
  * input (which must be memory safe because such an input might exist without
@@ -187,11 +1097,20 @@ static unsigned int lowzip_read1(lowzip_state *st, unsigned int offset) {
 static unsigned int lowzip_read_byte(lowzip_state *st) {
 	unsigned int x;
 
-	x = st->read_callback(st->udata, st->read_offset);
+	x = lowzip_read_input(st, st->read_offset);
 	if (!(x & 0x100U)) {
 		st->read_offset++;
 	} else {
-		/* Flag overrun for later detection. */
+		/* Flag overrun for later detection.  If more input is
+		 * expected past the input window, it's not an error: the
+		 * resumable decoder rolls back and asks for more input.
+		 */
+#if defined(LOWZIP_RESUMABLE)
+		if (st->input_more && st->read_offset >= st->input_offset &&
+		    st->read_offset - st->input_offset >= st->input_length) {
+			st->need_input = 1;
+		}
+#endif
 		st->have_error = 1;
 		x = 0;
 	}
@@ -202,7 +1121,7 @@ static unsigned int lowzip_read_byte(lowzip_state *st) {
  * Section 3.1.1.
  */
 static unsigned int lowzip_read_bits(lowzip_state *st, unsigned int nbits) {
-	unsigned int curr;
+	lowzip_bitbuf curr;
 	unsigned int have;
 	unsigned int x;
 	unsigned int mask;
@@ -213,12 +1132,12 @@ static unsigned int lowzip_read_bits(lowzip_state *st, unsigned int nbits) {
 
 	while (have < nbits) {
 		x = lowzip_read_byte(st);
-		curr |= (x << have);
+		curr |= ((lowzip_bitbuf) x << have);
 		have += 8;
 	}
 
 	mask = (1U << nbits) - 1U;
-	res = curr & mask;
+	res = (unsigned int) curr & mask;
 	st->have = have - nbits;
 	st->curr = curr >> nbits;
 
@@ -241,13 +1160,13 @@ static unsigned int lowzip_read_bits_reversed(lowzip_state *st, unsigned int nbi
 	return res;
 }
 #else
-static unsigned int lowzip_read_bits_reversed(lowzip_state *st, unsigned int nbits) {
-	unsigned int tmp;
+#if defined(LOWZIP_FAST_HUFFMAN) || defined(LOWZIP_FAST_BITREADER) || !defined(LOWZIP_FAST_STATIC_HUFFMAN)
+/* Reverse the order of the low 'nbits' bits of 'tmp'. */
+static unsigned int lowzip_reverse_bits(unsigned int tmp, unsigned int nbits) {
 	unsigned int res;
 	unsigned int mask1;
 	unsigned int mask2;
 
-	tmp = lowzip_read_bits(st, nbits);
 	res = 0;
 	mask1 = (1U << nbits);
 	mask2 = 1U;
@@ -266,17 +1185,161 @@ static unsigned int lowzip_read_bits_reversed(lowzip_state *st, unsigned int nbi
 }
 #endif
 
-static void lowzip_reset_bitstate(lowzip_state *st) {
-#if 0
-	st->curr = 0;  /* Not necessary because of masking. */
+#if !defined(LOWZIP_FAST_STATIC_HUFFMAN) && (!defined(LOWZIP_FAST_BITREADER) || defined(LOWZIP_SPECULATIVE))
+static unsigned int lowzip_read_bits_reversed(lowzip_state *st, unsigned int nbits) {
+	return lowzip_reverse_bits(lowzip_read_bits(st, nbits), nbits);
+}
+#endif
 #endif
+
+/* Reset bitstream state.  Bits above 'have' in 'curr' are always either
+ * zero or the next input bits (the fast bit reader may load ahead), which
+ * Huffman table lookups rely on.
+ */
+static void lowzip_reset_bitstate(lowzip_state *st) {
+	st->curr = 0;
 	st->have = 0;
 }
 
+#if defined(LOWZIP_FAST_BITREADER)
+/* Load 8 input bytes as a little endian value, a single unaligned load
+ * on little endian targets.
+ */
+static lowzip_bitbuf lowzip_load_le64(const unsigned char *p) {
+	lowzip_bitbuf x;
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (sizeof(x) == 8) {
+		memcpy((void *) &x, (const void *) p, 8);
+		return x;
+	}
+#endif
+	x = (lowzip_bitbuf) p[0] | ((lowzip_bitbuf) p[1] << 8U) |
+	    ((lowzip_bitbuf) p[2] << 16U) | ((lowzip_bitbuf) p[3] << 24U) |
+	    ((lowzip_bitbuf) p[4] << 32U) | ((lowzip_bitbuf) p[5] << 40U) |
+	    ((lowzip_bitbuf) p[6] << 48U) | ((lowzip_bitbuf) p[7] << 56U);
+	return x;
+}
+#endif  /* LOWZIP_FAST_BITREADER */
+
 /*
  *  Huffman decoding
  */
 
+#if defined(LOWZIP_FAST_HUFFMAN)
+/* Lookup tables allow a whole terminal value to be decoded with one lookup
+ * (two for codes longer than the root bits).  A table is placed right after
+ * the codes of a Huffman table and its offset is stored into counts[0]: zero
+ * length codes aren't needed for decoding.  The first table entry contains
+ * the root bit count, or zero if the code is over-subscribed or too large
+ * for the table in which case decoding falls back to the bit-at-a-time
+ * decoder.
+ *
+ * Table preparation is split into three parts: this init function which
+ * runs after counting code lengths, filling root entries for short codes
+ * while sorting terminal values in prepare_huffman(), and adding sub-tables
+ * for long codes in prepare_huffman_fast_sub().
+ *
+ * Returns the root bit count, or zero if no table can be used.  Also sets
+ * 'next_code' to the first (canonical) code for each code length.
+ */
+static unsigned int lowzip_prepare_huffman_fast_init(unsigned short *huff, unsigned int code_lens_count, unsigned short *next_code) {
+	unsigned short *fast;
+	unsigned int root_bits;
+	unsigned int len, code, i;
+	int left;
+
+	huff[0] = (unsigned short) (16 + code_lens_count);
+	fast = huff + huff[0];
+	fast[0] = 0;
+	root_bits = code_lens_count > 32 ? LOWZIP_FAST_LIT_BITS : LOWZIP_FAST_DIST_BITS;
+
+	/* Over-subscribed codes can't be represented in a table.  Incomplete
+	 * codes are fine: unused entries decode as invalid.
+	 */
+	left = 1;
+	code = 0;
+	for (len = 1; len <= 15; len++) {
+		left = (left << 1) - (int) huff[len];
+		if (left < 0) {
+			return 0;
+		}
+		next_code[len] = (unsigned short) code;
+		code = (code + huff[len]) << 1U;
+	}
+
+	for (i = 0; i < (1U << root_bits); i++) {
+		fast[1 + i] = (unsigned short) ((root_bits << 12) | LOWZIP_FAST_INVALID);
+	}
+	return root_bits;
+}
+
+/* Add sub-tables for codes longer than the root bits and mark the table
+ * usable.  Codes are assigned in the same canonical order as 'codes' lists
+ * them, so codes sharing a root prefix are consecutive and each sub-table
+ * can be sized and filled once, similarly to zlib inflate_table().  'sym'
+ * is the index of the first long code in 'codes'.
+ */
+static void lowzip_prepare_huffman_fast_sub(unsigned short *huff, unsigned int root_bits, unsigned short *next_code, unsigned int sym) {
+	unsigned short *fast;
+	unsigned short *sub;
+	unsigned int max_size, max_len;
+	unsigned int len, n, code, rev, prefix, sub_bits, used, i, l;
+	int left;
+
+	fast = huff + huff[0];
+	max_size = root_bits == LOWZIP_FAST_LIT_BITS ? LOWZIP_FAST_LIT_SIZE : LOWZIP_FAST_DIST_SIZE;
+	for (max_len = 15; max_len > root_bits && huff[max_len] == 0; max_len--) {
+	}
+
+	used = 1U << root_bits;
+	prefix = 1U << root_bits;  /* No current sub-table. */
+	sub = NULL;
+	sub_bits = 0;
+
+	for (len = root_bits + 1; len <= max_len; len++) {
+		for (n = huff[len]; n > 0; n--) {
+			/* Codes are read MSB first but the bitstream is LSB first,
+			 * so index the table with the reversed code.
+			 */
+			code = next_code[len]++;
+			rev = lowzip_reverse_bits(code, len);
+
+			if ((rev & ((1U << root_bits) - 1U)) != prefix) {
+				/* New sub-table: size it to fit all remaining codes
+				 * with this prefix.
+				 */
+				prefix = rev & ((1U << root_bits) - 1U);
+				sub_bits = len - root_bits;
+				left = 1 << sub_bits;
+				l = len;
+				left -= (int) n;
+				while (left > 0 && l < max_len) {
+					sub_bits++;
+					l++;
+					left = (left << 1) - (int) huff[l];
+				}
+				if (used + (1U << sub_bits) > max_size) {
+					return;
+				}
+				sub = fast + 1 + used;
+				for (i = 0; i < (1U << sub_bits); i++) {
+					sub[i] = (unsigned short) ((sub_bits << 12) | LOWZIP_FAST_INVALID);
+				}
+				fast[1 + prefix] = (unsigned short) ((sub_bits << 12) | LOWZIP_FAST_LINK | used);
+				used += 1U << sub_bits;
+			}
+
+			for (i = rev >> root_bits; i < (1U << sub_bits); i += 1U << (len - root_bits)) {
+				sub[i] = (unsigned short) (((len - root_bits) << 12) | huff[sym]);
+			}
+			sym++;
+		}
+	}
+
+	fast[0] = (unsigned short) root_bits;
+}
+#endif  /* LOWZIP_FAST_HUFFMAN */
+
 /* Prepare a Huffman decoding table for a sequence of code lengths.
  * Code lengths are given as 8-bit values in 'code_lens', with
  * 'code_lens_count' elements.
@@ -310,9 +1373,16 @@ static void lowzip_prepare_huffman(lowzip_state *st,
                                    unsigned char *code_lens,
                                    unsigned int code_lens_count,
                                    unsigned short *out_huff) {     /* See required size in comments above. */
-	unsigned int i, j, t;
+	unsigned int i, t;
 	unsigned short *out_counts;
 	unsigned short *out_codes;
+	unsigned short offsets[16];
+#if defined(LOWZIP_FAST_HUFFMAN)
+	unsigned short next_code[16];
+	unsigned short *fast;
+	unsigned int root_bits;
+	unsigned int rev;
+#endif
 
 	/* Count number of codes (terminals) for each code length.
 	 * Zero length, signifying an unused terminal, is counted but
@@ -342,9 +1412,10 @@ static void lowzip_prepare_huffman(lowzip_state *st,
 	 * It gives the terminal values for each code length tree level
 	 * in sequence.
 	 *
-	 * This is quite slow now because we make a lot of passes over the
-	 * code lengths to avoid temporaries.  A faster in-place solution
-	 * should be possible.
+	 * Codes are sorted by code length with a counting sort: 'offsets'
+	 * gives the next free index for each code length so that a single
+	 * pass over the code lengths suffices.  Terminal values of the same
+	 * length stay in increasing order as canonical Huffman codes need.
 	 */
 
 	/* XXX: codes are limited to 9 bits, so maybe the highest bit could
@@ -353,35 +1424,109 @@ static void lowzip_prepare_huffman(lowzip_state *st,
 	 * cost of probably less than that.
 	 */
 
-#if defined(LOWZIP_DEBUG)
-	fprintf(stderr, "codes:");
+	t = 0;
+	for (i = 1; i <= 15; i++) {
+		offsets[i] = (unsigned short) t;
+		t += out_counts[i];
+	}
+
+#if defined(LOWZIP_FAST_HUFFMAN)
+	root_bits = lowzip_prepare_huffman_fast_init(out_huff, code_lens_count, next_code);
+	fast = out_huff + out_huff[0];
 #endif
 
 	out_codes = out_huff + 16;
-	for (i = 1; i <= 15; i++) {  /* Code length (bits), ignore zero length codes. */
-#if defined(LOWZIP_DEBUG)
-		fprintf(stderr, " |");
-#endif
-		for (j = 0; j < code_lens_count; j++) {  /* Input code lengths. */
-			if (code_lens[j] == i) {
-				*out_codes++ = j;  /* Index = terminal value. */
-#if defined(LOWZIP_DEBUG)
-				fprintf(stderr, " %u", (unsigned int) j);
-#endif
+	for (i = 0; i < code_lens_count; i++) {  /* Index = terminal value. */
+		t = code_lens[i];
+		if (t == 0) {
+			continue;  /* Ignore zero length codes. */
+		}
+		out_codes[offsets[t]++] = (unsigned short) i;
+#if defined(LOWZIP_FAST_HUFFMAN)
+		if (t <= root_bits) {
+			/* Short code: fill all root entries with the code as
+			 * a (reversed) prefix.
+			 */
+			for (rev = lowzip_reverse_bits(next_code[t]++, t); rev < (1U << root_bits); rev += 1U << t) {
+				fast[1 + rev] = (unsigned short) ((t << 12) | i);
 			}
 		}
+#endif
 	}
 
 #if defined(LOWZIP_DEBUG)
+	fprintf(stderr, "codes:");
+	for (i = 0; i < offsets[15]; i++) {  /* Number of non-zero length codes. */
+		fprintf(stderr, " %u", (unsigned int) out_codes[i]);
+	}
 	fprintf(stderr, "\n");
 #endif
 
+#if defined(LOWZIP_FAST_HUFFMAN)
+	if (root_bits > 0) {
+		/* After the pass offsets[root_bits] is the index of the
+		 * first long code.
+		 */
+		lowzip_prepare_huffman_fast_sub(out_huff, root_bits, next_code, 16 + offsets[root_bits]);
+	}
+#endif
 	return;
 
  format_error:
 	st->have_error = 1;
 }
 
+#if defined(LOWZIP_FAST_TABLES)
+/* Huffman decode a terminal value using a lookup table prepared by
+ * prepare_huffman_fast() or a static lookup table.  Input bytes are only read when the entry
+ * looked up so far needs more bits than are available, so that the
+ * decoder never reads ahead of the code being decoded.  Bits above
+ * st->have are zero or the next input bits, so a lookup with too few
+ * bits is harmless.
+ */
+static unsigned int lowzip_decode_huffman_fast(lowzip_state *st, const unsigned short *fast) {
+	unsigned int root_bits;
+	unsigned int entry;
+	unsigned int nbits;
+	const unsigned short *sub;
+
+	root_bits = fast[0];
+	for (;;) {
+		entry = fast[1 + ((unsigned int) st->curr & ((1U << root_bits) - 1U))];
+		nbits = (entry & LOWZIP_FAST_LINK) ? root_bits : (entry >> 12);
+		if (nbits <= st->have) {
+			break;
+		}
+		st->curr |= (lowzip_bitbuf) lowzip_read_byte(st) << st->have;
+		st->have += 8;
+	}
+
+	if (entry & LOWZIP_FAST_LINK) {
+		sub = fast + 1 + (entry & LOWZIP_FAST_VALUE_MASK);
+		nbits = entry >> 12;  /* Sub-table index bits. */
+		for (;;) {
+			entry = sub[(unsigned int) (st->curr >> root_bits) & ((1U << nbits) - 1U)];
+			if (root_bits + (entry >> 12) <= st->have) {
+				break;
+			}
+			st->curr |= (lowzip_bitbuf) lowzip_read_byte(st) << st->have;
+			st->have += 8;
+		}
+		nbits = root_bits + (entry >> 12);
+	}
+
+	st->curr >>= nbits;
+	st->have -= nbits;
+
+	if ((entry & LOWZIP_FAST_VALUE_MASK) == LOWZIP_FAST_INVALID) {
+		/* Unused code in an incomplete code set. */
+		st->have_error = 1;
+		return 0;
+	}
+	return entry & LOWZIP_FAST_VALUE_MASK;
+}
+#endif  /* LOWZIP_FAST_TABLES */
+
 /* Huffman decode a terminal value from the input. */
 static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff) {
 	unsigned int code;
@@ -390,6 +1535,12 @@ static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff
 	unsigned int codes_offset;
 	int i;
 
+#if defined(LOWZIP_FAST_HUFFMAN)
+	if (huff[huff[0]] != 0) {
+		return lowzip_decode_huffman_fast(st, huff + huff[0]);
+	}
+#endif
+
 	code = 0;
 	code_start = 0;
 	codes_offset = 0;
@@ -445,59 +1596,479 @@ static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff
  *  Inflate block decoding
  */
 
-/* Decode an uncompressed block. */
-static void lowzip_decode_uncompressed_block(lowzip_state *st) {
-	unsigned int len;
-
-	/* Discard unused partially read bits. */
-	lowzip_reset_bitstate(st);
+#if defined(LOWZIP_RESUMABLE)
+/* Save the current input and output position as the point where decoding
+ * resumes if input runs out, see lowzip_inflate_resume().  Block level
+ * progress (st->mode, st->block_remain) is only updated at checkpoints so
+ * that it stays consistent with the saved position.
+ */
+static void lowzip_checkpoint(lowzip_state *st) {
+	st->cp_read_offset = st->read_offset;
+	st->cp_curr = st->curr;
+	st->cp_have = st->have;
+	st->cp_output_next = st->output_next;
+}
 
-	/* Parse block length.  Ignore one's complement of length which
+/* Return to the most recent checkpoint, discarding the effects of a
+ * partially decoded symbol (or header).  Output is only flushed after all
+ * input for a symbol has been read, so the output pointer is still valid.
+ */
+static void lowzip_rollback(lowzip_state *st) {
+	st->read_offset = st->cp_read_offset;
+	st->curr = st->cp_curr;
+	st->have = st->cp_have;
+	st->output_next = st->cp_output_next;
+}
+#else
+#define lowzip_checkpoint(st)  ((void) 0)
+#endif  /* LOWZIP_RESUMABLE */
+
+/* Finish a block: update running CRC-32 and move to the next block. */
+static void lowzip_end_block(lowzip_state *st) {
+	lowzip_update_output_crc(st);
+	st->mode = st->block_final ? LOWZIP_MODE_DONE : LOWZIP_MODE_HEADER;
+}
+
+/* Decode an uncompressed block header. */
+static void lowzip_decode_stored_header(lowzip_state *st) {
+	unsigned int len;
+
+	/* Discard unused partially read bits.  The fast bit reader may also
+	 * hold whole bytes which are consumed before reading input directly.
+	 */
+	lowzip_read_bits(st, st->have & 0x07U);
+
+	/* Parse block length.  Ignore one's complement of length which
 	 * is for error checking.  Checking it would be OK but somewhat
 	 * pointless because no other part of the deflate stream has any
 	 * redundancy checks.
 	 */
-	len = lowzip_read_byte(st);
-	len += lowzip_read_byte(st) << 8U;
-	lowzip_read_byte(st);  /* Skip NLEN. */
-	lowzip_read_byte(st);
+	len = lowzip_read_bits(st, 16);
+	lowzip_read_bits(st, 16);  /* Skip NLEN. */
+	if (!st->have_error) {
+		st->block_remain = len;
+		st->mode = LOWZIP_MODE_STORED_COPY;
+	}
+}
+
+/* Copy uncompressed block data, st->block_remain bytes left. */
+static void lowzip_decode_stored_data(lowzip_state *st) {
+	unsigned int len;
+	unsigned int n;
+	const unsigned char *p;
+
+	len = st->block_remain;
+	while (len > 0) {
+		if (st->have_error) {
+			return;
+		}
+		lowzip_checkpoint(st);
+		st->block_remain = len;
+
+		if (st->have > 0) {
+			/* Whole bytes left in the bit buffer. */
+			lowzip_write_byte(st, (unsigned char) lowzip_read_bits(st, 8));
+			len--;
+			continue;
+		}
+		st->curr = 0;  /* Drop any loaded ahead bits, input is read directly. */
+
+		/* Copy bytes to output verbatim, directly from the input
+		 * window if possible.  Chunks are limited to what's available
+		 * in the window and fits the output (window when streaming).
+		 */
+		p = lowzip_input_span(st, st->read_offset, 1);
+		if (p) {
+			if (!lowzip_reserve_output(st, 1)) {
+				return;
+			}
+			n = st->input_offset + st->input_length - st->read_offset;
+			if (n > len) {
+				n = len;
+			}
+			if ((ptrdiff_t) n > (ptrdiff_t) (st->output_end - st->output_next)) {
+				n = (unsigned int) (st->output_end - st->output_next);
+			}
+			memcpy((void *) st->output_next, (const void *) p, n);
+			st->output_next += n;
+			st->read_offset += n;
+			len -= n;
+		} else {
+			lowzip_write_byte(st, lowzip_read_byte(st));
+			len--;
+		}
+	}
+	if (!st->have_error) {
+		st->block_remain = 0;
+		lowzip_end_block(st);
+	}
+}
 
-	/* Copy bytes to output verbatim. */
+#if !defined(LOWZIP_FAST_BITREADER) || defined(LOWZIP_SPECULATIVE)
+/* Decode a literal/length symbol using static or dynamic Huffman trees.
+ * Static trees are defined in RFC 1951 Section 3.2.6, decoded manually
+ * instead of using an actual tree.
+ */
+static unsigned int lowzip_decode_lit_symbol(lowzip_state *st, int static_huffman) {
+	unsigned int t;
+
+	if (!static_huffman) {
+		/* Dynamic Huffman. */
+		return lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT));
+	}
+#if defined(LOWZIP_FAST_STATIC_HUFFMAN)
+	/* Static Huffman, precomputed lookup table. */
+	t = lowzip_decode_huffman_fast(st, lowzip_static_lit);
+#else
+	/* Static Huffman, hand-crafted decoder. */
+	t = lowzip_read_bits_reversed(st, 7);  /* Minimum code length is 7. */
+	if (t <= 0x17U) {
+		t += 256;
+	} else if (t <= 0x5f) {
+		t = (t << 1U) + lowzip_read_bits(st, 1) - 48;
+	} else if (t <= 0x63) {
+		t = (t << 1U) + lowzip_read_bits(st, 1) + 88;
+	} else {
+		t = (t << 2U) + lowzip_read_bits_reversed(st, 2) - 256;
+	}
+#endif
+	return t;
+}
+
+/* Decode a distance symbol using static or dynamic Huffman trees. */
+static unsigned int lowzip_decode_dist_symbol(lowzip_state *st, int static_huffman) {
+	if (!static_huffman) {
+		/* Dynamic Huffman. */
+		return lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST));
+	}
+#if defined(LOWZIP_FAST_STATIC_HUFFMAN)
+	/* Static Huffman, precomputed lookup table. */
+	return lowzip_decode_huffman_fast(st, lowzip_static_dist);
+#else
+	/* Static Huffman, hand-crafted decoder. */
+	return lowzip_read_bits_reversed(st, 5);  /* Fixed 5-bit code, use as is. */
+#endif
+}
+#endif  /* !LOWZIP_FAST_BITREADER || LOWZIP_SPECULATIVE */
+
+#if defined(LOWZIP_FAST_COPY)
+/* Copy a back-reference of 'len' bytes from 'dist' bytes back, returns the
+ * updated output pointer.  Caller has checked both bounds.  Deflate allows
+ * the source to overlap the output (e.g. distance=2 and length=5), so the
+ * chunked copies below are only used when a chunk can't overlap the bytes
+ * it writes.
+ */
+static unsigned char *lowzip_copy_match(unsigned char *out, unsigned int dist, unsigned int len) {
+	unsigned int wide, n;
+
+	if (dist == 1) {
+		/* Run of a single byte. */
+		memset((void *) out, (int) out[-1], len);
+		return out + len;
+	}
+	if (dist < 8 && dist < len) {
+		/* Short repeating pattern: output with period 'dist' also
+		 * repeats with any multiple of 'dist'.  Write the pattern
+		 * byte-wise until the multiple reaching 8 bytes can be used
+		 * as the copy distance, then continue with 8-byte chunks.
+		 */
+		wide = ((7U + dist) / dist) * dist;
+		for (n = wide - dist; n > 0 && len > 0; n--, len--) {
+			*out = *(out - dist);
+			out++;
+		}
+		dist = wide;
+	}
+
+	while (len >= 32 && dist >= 32) {
+		memcpy((void *) out, (const void *) (out - dist), 32);
+		out += 32;
+		len -= 32;
+	}
+	while (len >= 16 && dist >= 16) {
+		memcpy((void *) out, (const void *) (out - dist), 16);
+		out += 16;
+		len -= 16;
+	}
+	while (len >= 8) {
+		/* dist >= 8 here: either dist was >= 8 or len was < 8. */
+		memcpy((void *) out, (const void *) (out - dist), 8);
+		out += 8;
+		len -= 8;
+	}
 	while (len-- > 0) {
-		lowzip_write_byte(st, lowzip_read_byte(st));
+		*out = *(out - dist);
+		out++;
+	}
+	return out;
+}
+#endif  /* LOWZIP_FAST_COPY */
+
+#if defined(LOWZIP_FAST_BITREADER)
+/* Read input bytes into the bit buffer until at least 'nbits' bits are
+ * available.  Used near the end of the input window.
+ */
+static void lowzip_fill_bits(lowzip_state *st, unsigned int nbits) {
+	while (st->have < nbits) {
+		st->curr |= (lowzip_bitbuf) lowzip_read_byte(st) << st->have;
+		st->have += 8;
+	}
+}
+
+#if defined(LOWZIP_FAST_TABLES)
+/* Look up a terminal value from a Huffman lookup table using peeked bits,
+ * caller ensures there are at least 15 bits.  Returns the number of bits
+ * consumed shifted left by 16, plus the terminal value.
+ */
+static unsigned int lowzip_fast_lookup(const unsigned short *fast, lowzip_bitbuf bits) {
+	unsigned int root_bits;
+	unsigned int entry;
+
+	root_bits = fast[0];
+	entry = fast[1 + ((unsigned int) bits & ((1U << root_bits) - 1U))];
+	if (entry & LOWZIP_FAST_LINK) {
+		entry = fast[1 + (entry & LOWZIP_FAST_VALUE_MASK) +
+		             ((unsigned int) (bits >> root_bits) & ((1U << (entry >> 12)) - 1U))];
+		return ((root_bits + (entry >> 12)) << 16) + (entry & LOWZIP_FAST_VALUE_MASK);
 	}
+	return ((entry >> 12) << 16) + (entry & LOWZIP_FAST_VALUE_MASK);
 }
+#endif
+
+/* Bitstream state is kept in local variables while decoding block data:
+ * LOWZIP_LOAD() and LOWZIP_SAVE() move it between 'st' and the locals
+ * around calls to state based helpers.  Bytes [in,in_end[ are the rest
+ * of the input window; when read_offset is outside the window the range
+ * is empty and input is read using the state based helpers.
+ * LOWZIP_CHECKPOINT() is lowzip_checkpoint() for the locals.
+ */
+#define LOWZIP_LOAD() do { \
+		curr = st->curr; \
+		have = st->have; \
+		in = lowzip_input_span(st, st->read_offset, 1); \
+		if (in) { \
+			in_end = st->input_data + st->input_length; \
+		} else { \
+			in = st->input_buf; \
+			in_end = in; \
+		} \
+		in_start = in; \
+	} while (0)
+#define LOWZIP_SAVE() do { \
+		st->curr = curr; \
+		st->have = have; \
+		st->read_offset += (unsigned int) (in - in_start); \
+	} while (0)
+
+/* Refill the bit buffer to 56-63 bits with a single 8-byte load if there
+ * are 8 bytes left in the input window, otherwise do nothing.  Bytes only
+ * partially fitting the buffer are loaded again on the next refill.
+ */
+#define LOWZIP_FILL() do { \
+		if (in_end - in >= 8) { \
+			curr |= lowzip_load_le64(in) << have; \
+			in += (63U - have) >> 3U; \
+			have |= 56U; \
+		} \
+	} while (0)
+
+/* Ensure 'n' bits are available.  Near the end of input read byte by byte
+ * so that the reader doesn't read further than needed.
+ */
+#define LOWZIP_NEEDBITS(n) do { \
+		if (have < (n)) { \
+			LOWZIP_FILL(); \
+			if (have < (n)) { \
+				LOWZIP_SAVE(); \
+				lowzip_fill_bits(st, (n)); \
+				LOWZIP_LOAD(); \
+			} \
+		} \
+	} while (0)
+#if defined(LOWZIP_RESUMABLE)
+#define LOWZIP_CHECKPOINT() do { \
+		st->cp_read_offset = st->read_offset + (unsigned int) (in - in_start); \
+		st->cp_curr = curr; \
+		st->cp_have = have; \
+		st->cp_output_next = st->output_next; \
+	} while (0)
+#else
+#define LOWZIP_CHECKPOINT() do { } while (0)
+#endif
+#define LOWZIP_BITS(n)  ((unsigned int) curr & ((1U << (n)) - 1U))
+#define LOWZIP_DROPBITS(n) do { \
+		curr >>= (n); \
+		have -= (n); \
+	} while (0)
 
 /* Decode compressed data using static or dynamic length/literal and distance
- * Huffman trees.  Static trees are defined in RFC 1951 Section 3.2.6, decoded
- * manually instead of using an actual tree.
+ * Huffman trees, fast bit reader variant.  See the default variant below for
+ * comments.  Huffman codes are decoded from the local bit buffer when it has
+ * at least 15 bits (always, except near the end of input) and otherwise by
+ * the state based decoder which reads only as far as needed.
  */
 static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffman) {
+	lowzip_bitbuf curr;
+	unsigned int have;
+	const unsigned char *in;
+	const unsigned char *in_start;
+	const unsigned char *in_end;
+	unsigned short *huff_lit;
+	unsigned short *huff_dist;
+#if defined(LOWZIP_FAST_TABLES)
+	const unsigned short *fast_lit;
+	const unsigned short *fast_dist;
+#endif
 	unsigned int t;
 
+	huff_lit = (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT);
+	huff_dist = (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST);
+#if defined(LOWZIP_FAST_TABLES)
+	fast_lit = NULL;
+	fast_dist = NULL;
+#if defined(LOWZIP_FAST_HUFFMAN)
+	if (!static_huffman) {
+		if (huff_lit[huff_lit[0]] != 0) {
+			fast_lit = huff_lit + huff_lit[0];
+		}
+		if (huff_dist[huff_dist[0]] != 0) {
+			fast_dist = huff_dist + huff_dist[0];
+		}
+	}
+#endif
+#if defined(LOWZIP_FAST_STATIC_HUFFMAN)
+	if (static_huffman) {
+		fast_lit = lowzip_static_lit;
+		fast_dist = lowzip_static_dist;
+	}
+#endif
+#endif
+
+	LOWZIP_LOAD();
+
 	for (;;) {
 		if (st->have_error) {
-#if defined(LOWZIP_DEBUG)
-			fprintf(stderr, "error at output offset %ld\n", (long) (st->output_next - st->output_start));
-#endif
 			break;
 		}
 
+#if defined(LOWZIP_FAST_TABLES)
+		/* Fast loop, similar to zlib inflate_fast(): while there are at
+		 * least 8 input bytes left in the window and room for a maximum
+		 * length match, one refill provides the at most 48 bits needed
+		 * for a literal/length code, length extra bits, a distance code
+		 * and distance extra bits, and no output bounds checks are
+		 * needed for writes.  Only the back-reference distance and code
+		 * validity are checked.  Near the end of the input window or
+		 * the output buffer decoding continues with the careful path
+		 * below one symbol at a time.
+		 */
+		if (fast_lit && fast_dist) {
+			unsigned char *out;
+			unsigned char *out_end;
+			unsigned int back_len;
+			unsigned int back_dist;
+
+			out = st->output_next;
+			out_end = st->output_end;
+			t = 0;
+			while (in_end - in >= 8 && out_end - out >= 258) {
+				LOWZIP_FILL();
+
+				t = lowzip_fast_lookup(fast_lit, curr);
+				LOWZIP_DROPBITS(t >> 16);
+				t &= 0xffffU;
+				if (t < 256) {
+					*out++ = (unsigned char) t;
+					continue;
+				}
+				if (t == 256 || t > 285) {
+					/* End of block or invalid code, handled below. */
+					break;
+				}
+				t -= 257;
+				back_len = (unsigned int) lowzip_len_base[t] + 3U + LOWZIP_BITS(lowzip_len_bits[t]);
+				LOWZIP_DROPBITS(lowzip_len_bits[t]);
+
+				t = lowzip_fast_lookup(fast_dist, curr);
+				LOWZIP_DROPBITS(t >> 16);
+				t &= 0xffffU;
+				if (t > 29) {
+					st->output_next = out;
+					goto format_error;
+				}
+				back_dist = lowzip_dist_base[t] + LOWZIP_BITS(lowzip_dist_bits[t]);
+				LOWZIP_DROPBITS(lowzip_dist_bits[t]);
+				if ((ptrdiff_t) back_dist > (ptrdiff_t) (out - st->output_start)) {
+					st->output_next = out;
+					goto format_error;
+				}
+#if defined(LOWZIP_FAST_COPY)
+				out = lowzip_copy_match(out, back_dist, back_len);
+#else
+				while (back_len-- > 0) {
+					*out = *(out - back_dist);
+					out++;
+				}
+#endif
+			}
+			st->output_next = out;
+			if (t == 256) {
+				break;
+			}
+			if (t > 285) {
+				goto format_error;
+			}
+		}
+#endif
+
+		LOWZIP_CHECKPOINT();
+
+		if (have < 15) {
+			LOWZIP_FILL();
+		}
+
+#if defined(LOWZIP_FAST_TABLES)
+		if (fast_lit && have >= 15) {
+			t = lowzip_fast_lookup(fast_lit, curr);
+			LOWZIP_DROPBITS(t >> 16);
+			t &= 0xffffU;
+			if (t == LOWZIP_FAST_INVALID) {
+				goto format_error;
+			}
+		} else
+#endif
 		if (!static_huffman) {
 			/* Dynamic Huffman. */
-			t = lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT));
+			LOWZIP_SAVE();
+			t = lowzip_decode_huffman(st, huff_lit);
+			LOWZIP_LOAD();
 		} else {
+#if defined(LOWZIP_FAST_STATIC_HUFFMAN)
+			/* Static Huffman, near end of input. */
+			LOWZIP_SAVE();
+			t = lowzip_decode_huffman_fast(st, lowzip_static_lit);
+			LOWZIP_LOAD();
+#else
 			/* Static Huffman, hand-crafted decoder. */
-			t = lowzip_read_bits_reversed(st, 7);  /* Minimum code length is 7. */
+			LOWZIP_NEEDBITS(7);  /* Minimum code length is 7. */
+			t = lowzip_reverse_bits(LOWZIP_BITS(7), 7);
+			LOWZIP_DROPBITS(7);
 			if (t <= 0x17U) {
 				t += 256;
 			} else if (t <= 0x5f) {
-				t = (t << 1U) + lowzip_read_bits(st, 1) - 48;
+				LOWZIP_NEEDBITS(1);
+				t = (t << 1U) + LOWZIP_BITS(1) - 48;
+				LOWZIP_DROPBITS(1);
 			} else if (t <= 0x63) {
-				t = (t << 1U) + lowzip_read_bits(st, 1) + 88;
+				LOWZIP_NEEDBITS(1);
+				t = (t << 1U) + LOWZIP_BITS(1) + 88;
+				LOWZIP_DROPBITS(1);
 			} else {
-				t = (t << 2U) + lowzip_read_bits_reversed(st, 2) - 256;
+				LOWZIP_NEEDBITS(2);
+				t = (t << 2U) + lowzip_reverse_bits(LOWZIP_BITS(2), 2) - 256;
+				LOWZIP_DROPBITS(2);
 			}
+#endif
 		}
 
 		if (t < 256) {
@@ -513,15 +2084,101 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 			}
 			t -= 257;
 
-			back_len = (unsigned int) lowzip_len_base[t] + 3U + lowzip_read_bits(st, lowzip_len_bits[t]);
+			LOWZIP_NEEDBITS(lowzip_len_bits[t]);
+			back_len = (unsigned int) lowzip_len_base[t] + 3U + LOWZIP_BITS(lowzip_len_bits[t]);
+			LOWZIP_DROPBITS(lowzip_len_bits[t]);
 
+			if (have < 15) {
+				LOWZIP_FILL();
+			}
+#if defined(LOWZIP_FAST_TABLES)
+			if (fast_dist && have >= 15) {
+				t = lowzip_fast_lookup(fast_dist, curr);
+				LOWZIP_DROPBITS(t >> 16);
+				t &= 0xffffU;
+			} else
+#endif
 			if (!static_huffman) {
 				/* Dynamic Huffman. */
-				t = lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST));
+				LOWZIP_SAVE();
+				t = lowzip_decode_huffman(st, huff_dist);
+				LOWZIP_LOAD();
 			} else {
-				/* Static Huffman, hand-crafted decoder. */
-				t = lowzip_read_bits_reversed(st, 5);  /* Fixed 5-bit code, use as is. */
+				/* Static Huffman, fixed 5-bit code. */
+				LOWZIP_NEEDBITS(5);
+				t = lowzip_reverse_bits(LOWZIP_BITS(5), 5);
+				LOWZIP_DROPBITS(5);
+			}
+			if (t > 29) {
+				/* Also catches LOWZIP_FAST_INVALID. */
+				goto format_error;
+			}
+
+			LOWZIP_NEEDBITS(lowzip_dist_bits[t]);
+			back_dist = lowzip_dist_base[t] + LOWZIP_BITS(lowzip_dist_bits[t]);
+			LOWZIP_DROPBITS(lowzip_dist_bits[t]);
+
+			if ((ptrdiff_t) back_dist > (ptrdiff_t) (st->output_next - st->output_start)) {
+				goto format_error;
+			}
+			if (!lowzip_reserve_output(st, back_len)) {
+				goto buffer_error;
+			}
+
+#if defined(LOWZIP_FAST_COPY)
+			st->output_next = lowzip_copy_match(st->output_next, back_dist, back_len);
+#else
+			while (back_len-- > 0) {
+				*st->output_next = *(st->output_next - back_dist);
+				st->output_next++;
+			}
+#endif
+		}
+	}
+
+	LOWZIP_SAVE();
+	return;
+
+ format_error:
+ buffer_error:
+	LOWZIP_SAVE();
+	st->have_error = 1;
+}
+#else  /* LOWZIP_FAST_BITREADER */
+/* Decode compressed data using static or dynamic length/literal and distance
+ * Huffman trees.
+ */
+static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffman) {
+	unsigned int t;
+
+	for (;;) {
+		if (st->have_error) {
+#if defined(LOWZIP_DEBUG)
+			fprintf(stderr, "error at output offset %ld\n", (long) (st->output_next - st->output_start));
+#endif
+			break;
+		}
+
+		lowzip_checkpoint(st);
+
+		t = lowzip_decode_lit_symbol(st, static_huffman);
+
+		if (t < 256) {
+			lowzip_write_byte(st, (unsigned char) t);
+		} else if (t == 256) {
+			break;
+		} else {
+			unsigned int back_len;
+			unsigned int back_dist;
+
+			if (t > 285) {
+				goto format_error;
 			}
+			t -= 257;
+
+			back_len = (unsigned int) lowzip_len_base[t] + 3U + lowzip_read_bits(st, lowzip_len_bits[t]);
+
+			t = lowzip_decode_dist_symbol(st, static_huffman);
 			if (t > 29) {
 				goto format_error;
 			}
@@ -532,8 +2189,10 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 				/* Back-reference goes too far back. */
 				goto format_error;
 			}
-			if ((ptrdiff_t) back_len > (ptrdiff_t) (st->output_end - st->output_next)) {
-				/* Not enough space for output. */
+			if (!lowzip_reserve_output(st, back_len)) {
+				/* Not enough space for output, or flushing
+				 * streamed output failed.
+				 */
 				goto buffer_error;
 			}
 			/* back_dist cannot be 0: lowzip_dist_base[] entries
@@ -552,10 +2211,14 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 			 * any special casing.  Output space has already been
 			 * checked for above.
 			 */
+#if defined(LOWZIP_FAST_COPY)
+			st->output_next = lowzip_copy_match(st->output_next, back_dist, back_len);
+#else
 			while (back_len-- > 0) {
 				*st->output_next = *(st->output_next - back_dist);
 				st->output_next++;
 			}
+#endif
 		}
 	}
 
@@ -565,28 +2228,19 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
  buffer_error:
 	st->have_error = 1;
 }
+#endif  /* LOWZIP_FAST_BITREADER */
 
-/* Decode a static Huffman block.  Conceptually initialize or use a
- * pre-initialized Huffman tree specified in RFC 1951 Section 3.2.6.
- * In practice the static Huffman tree is simple enough to be decoded
- * without an explicit Huffman tree.
+/* Decode dynamic Huffman table sizes and the code length Huffman table
+ * used to decode the code lengths of the length/literal and distance
+ * Huffman tables.
  */
-static void lowzip_decode_static_huffman_block(lowzip_state *st) {
-	lowzip_decode_huffman_block_data(st, 1 /*static_huffman*/);
-}
-
-/* Decode a dynamic Huffman block.  Initialize length/literal and distance
- * Huffman trees using a temporary code length Huffman tree.  Then proceed
- * to decode block data using the trees.
- */
-static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
+static void lowzip_decode_dynamic_huffman_table(lowzip_state *st) {
 	unsigned int nlit;
 	unsigned int ndist;
 	unsigned int nclen;
 	unsigned int i;
 
 	unsigned char *codelen_code_lens;
-	unsigned char *temp_code_lens;
 
 	/* Decode dynamic Huffman table length fields.
 	 *
@@ -605,12 +2259,16 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 	 * temporaries and the Huffman table itself:
 	 *
 	 *    [0,70[:   code length Huffman table (32 + 19x2 = 70)
-	 *    [70,89[:  codelen_code_lens
+	 *    [end-339,end-320[:  codelen_code_lens
+	 *
+	 * With LOWZIP_FAST_HUFFMAN the lookup table follows at offset 70
+	 * and is filled while codelen_code_lens are still being read, so
+	 * they're placed right below the temporary code lengths used below.
 	 *
 	 * Code length alphabet uses codes 0-18.
 	 */
 
-	codelen_code_lens = (unsigned char *) ((unsigned char *) st->scratch + 70);
+	codelen_code_lens = (unsigned char *) st->scratch + sizeof(st->scratch) - 320 - 19;
 	memset((void *) codelen_code_lens, 0, 19);
 	for (i = 0; i < nclen; i++) {
 		codelen_code_lens[lowzip_codelen_order[i]] = lowzip_read_bits(st, 3);
@@ -626,6 +2284,26 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 		return;
 	}
 
+	st->nlit = nlit;
+	st->ndist = ndist;
+	st->block_remain = 0;
+	st->mode = LOWZIP_MODE_CODELENS;
+}
+
+/* Decode code lengths for the length/literal and distance Huffman tables
+ * and prepare the tables.  st->block_remain is the number of code lengths
+ * decoded so far, the code lengths themselves are kept in 'scratch'.
+ */
+static void lowzip_decode_dynamic_huffman_code_lengths(lowzip_state *st) {
+	unsigned int nlit;
+	unsigned int ndist;
+	unsigned int i;
+
+	unsigned char *temp_code_lens;
+
+	nlit = st->nlit;
+	ndist = st->ndist;
+
 	/* First step of preparing Huffman tables for literal/length and
 	 * distance alphabets is to decode the code lengths for these tables.
 	 * The code lengths are encoded as a single integer sequence using
@@ -634,11 +2312,17 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 	 */
 
 	temp_code_lens = (unsigned char *) st->scratch + sizeof(st->scratch) - 320;
-	for (i = 0; i != nlit + ndist;) {
+	for (i = st->block_remain; i != nlit + ndist;) {
 		unsigned int rep_count;
 		unsigned char rep_code;
 		unsigned int t;
 
+		if (st->have_error) {
+			return;
+		}
+		lowzip_checkpoint(st);
+		st->block_remain = i;
+
 		t = lowzip_decode_huffman(st, (unsigned short *) st->scratch);
 		if (t < 16) {
 			rep_code = t;
@@ -680,6 +2364,9 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 	/* When we finish, i == nlit + ndist and the sequence has ended
 	 * exactly without overwrite.
 	 */
+	if (st->have_error) {
+		return;
+	}
 
 	/* We now have the code lengths and are ready to prepare the actual
 	 * literal/length and distance Huffman tables.  The code length
@@ -701,104 +2388,995 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 		return;
 	}
 
-	/* Finally, decode the block contents. */
-
-	lowzip_decode_huffman_block_data(st, 0 /*static_huffman*/);
+	/* Finally, decode the block contents (LOWZIP_MODE_DYNAMIC). */
+	st->mode = LOWZIP_MODE_DYNAMIC;
 	return;
 
  format_error:
 	st->have_error = 1;
 }
 
-/* Deflate stream decoder, decode blocks until last block found. */
-static void lowzip_decode_inflate_blocks(lowzip_state *st) {
-	for (;;) {
-		unsigned int blockhdr;
+#if defined(LOWZIP_RANDOM_ACCESS)
+/* Record a checkpoint for lowzip_build_index() at the start of a block if
+ * it's at least 'spacing' bytes of output after the previous one.  The
+ * bit reader position is normalized so that only bits of a partially read
+ * byte (at most 7) are kept: whole bytes loaded ahead are re-read.
+ */
+static void lowzip_index_block(lowzip_state *st) {
+	lowzip_index *idx;
+	lowzip_index_point *pt;
+	unsigned int out_offset;
+	unsigned int prev;
+	unsigned int wlen;
+
+	idx = st->index;
+	out_offset = st->output_flushed + (unsigned int) (st->output_next - st->flush_next);
+	prev = (idx->num_points > 0 ? idx->points[idx->num_points - 1].out_offset : 0);
+	if (out_offset == prev || out_offset - prev < idx->spacing || idx->num_points >= idx->max_points) {
+		return;
+	}
+	wlen = (out_offset < 32768U ? out_offset : 32768U);
+	if (wlen > idx->windows_size - idx->windows_used) {
+		return;
+	}
+
+	pt = idx->points + idx->num_points++;
+	pt->out_offset = out_offset;
+	pt->in_offset = st->read_offset - (st->have >> 3U) - idx->data_offset;
+	pt->bits = (unsigned char) (st->have & 0x07U);
+	pt->bit_value = (unsigned char) (st->curr & ((1U << pt->bits) - 1U));
+	pt->window_offset = idx->windows_used;
+	pt->window_length = (unsigned short) wlen;
+	memcpy((void *) (idx->windows + idx->windows_used), (const void *) (st->output_next - wlen), wlen);
+	idx->windows_used += wlen;
+}
+#endif  /* LOWZIP_RANDOM_ACCESS */
 
+/* Deflate stream decoder, run the block level state machine until the last
+ * block is done or an error occurs.  Running out of input is an error too,
+ * which lowzip_inflate_resume() turns into a rollback when more input is
+ * expected.
+ */
+static void lowzip_inflate_run(lowzip_state *st) {
+	unsigned int blockhdr;
+
+	for (;;) {
 		if (st->have_error) {
 			return;
 		}
+		lowzip_checkpoint(st);
 
-		/* Block header is BFINAL (1 bit) and BTYPE (2 bits).  Read
-		 * as a single 3-bit field.  Due to deflate bit order, we get
-		 * (BTYPE << 1) + BFINAL.
-		 */
-		blockhdr = lowzip_read_bits(st, 3);
-
-		switch (blockhdr >> 1U) {
-		case 0:
-			/* Uncompressed. */
-			lowzip_decode_uncompressed_block(st);
+		switch (st->mode) {
+		case LOWZIP_MODE_HEADER:
+#if defined(LOWZIP_RANDOM_ACCESS)
+			if (st->index) {
+				lowzip_index_block(st);
+			}
+			/* Range read: stop at the first block boundary where
+			 * the pending output covers the rest of the range
+			 * instead of decoding until the window fills.
+			 */
+			if (st->range_next &&
+			    (unsigned int) (st->output_next - st->flush_next) > st->range_skip &&
+			    (unsigned int) (st->output_next - st->flush_next) - st->range_skip >= st->range_left) {
+				lowzip_flush_output(st);
+				break;  /* Range complete, bail out on next loop. */
+			}
+#endif
+			/* Block header is BFINAL (1 bit) and BTYPE (2 bits).
+			 * Read as a single 3-bit field.  Due to deflate bit
+			 * order, we get (BTYPE << 1) + BFINAL.
+			 */
+			blockhdr = lowzip_read_bits(st, 3);
+			if (st->have_error) {
+				break;
+			}
+			st->block_final = blockhdr & 0x01U;
+			switch (blockhdr >> 1U) {
+			case 0:
+				/* Uncompressed. */
+				st->mode = LOWZIP_MODE_STORED_LEN;
+				break;
+			case 1:
+				/* Static Huffman.  Conceptually initialize or
+				 * use a pre-initialized Huffman tree specified
+				 * in RFC 1951 Section 3.2.6.  In practice the
+				 * static Huffman tree is simple enough to be
+				 * decoded without an explicit Huffman tree.
+				 */
+				st->mode = LOWZIP_MODE_STATIC;
+				break;
+			case 2:
+				/* Dynamic Huffman.  Initialize length/literal
+				 * and distance Huffman trees using a temporary
+				 * code length Huffman tree, then decode block
+				 * data using the trees.
+				 */
+				st->mode = LOWZIP_MODE_TABLE;
+				break;
+			default:
+				/* Reserved/error. */
+				st->have_error = 1;
+				break;  /* Bail out on next loop. */
+			}
 			break;
-		case 1:
-			/* Static Huffman. */
-			lowzip_decode_static_huffman_block(st);
+		case LOWZIP_MODE_STORED_LEN:
+			lowzip_decode_stored_header(st);
 			break;
-		case 2:
-			/* Dynamic Huffman. */
-			lowzip_decode_dynamic_huffman_block(st);
+		case LOWZIP_MODE_STORED_COPY:
+			lowzip_decode_stored_data(st);
 			break;
-		default:
-			/* Reserved/error. */
-			st->have_error = 1;
-			break;  /* Bail out on next loop. */
-		}
-		if (blockhdr & 0x01U) {
-			/* BFINAL set, done. */
+		case LOWZIP_MODE_TABLE:
+			lowzip_decode_dynamic_huffman_table(st);
+			break;
+		case LOWZIP_MODE_CODELENS:
+			lowzip_decode_dynamic_huffman_code_lengths(st);
 			break;
+		case LOWZIP_MODE_STATIC:
+		case LOWZIP_MODE_DYNAMIC:
+			lowzip_decode_huffman_block_data(st, st->mode == LOWZIP_MODE_STATIC);
+			if (!st->have_error) {
+				lowzip_end_block(st);
+			}
+			break;
+		default:
+			/* LOWZIP_MODE_DONE. */
+			return;
 		}
 	}
 }
 
+/* Prepare state for a raw inflate starting at st->read_offset. */
+static void lowzip_inflate_start(lowzip_state *st) {
+	st->crc_next = NULL;  /* No CRC-32 for raw inflate. */
+	st->mode = LOWZIP_MODE_HEADER;
+	lowzip_init_output(st);
+	lowzip_reset_bitstate(st);
+}
+
 /* Main caller entrypoint.  Caller initializes the entire state structure
  * before making the call, and must check st->have_error after the call.
- * Decoded output is in [st->output_start,st->output_next[.
+ * Decoded output is in [st->output_start,st->output_next[, or has been
+ * passed to st->write_callback if set.
  */
 void lowzip_inflate_raw(lowzip_state *st) {
-	lowzip_reset_bitstate(st);
-	lowzip_decode_inflate_blocks(st);
+	lowzip_inflate_start(st);
+	lowzip_inflate_run(st);
+#if defined(LOWZIP_STREAMING)
+	if (st->write_callback && !st->have_error) {
+		lowzip_flush_output(st);
+	}
+#endif
 }
 
-/*
- *  ZIP CRC32
+#if defined(LOWZIP_RESUMABLE)
+/* Start a resumable raw inflate.  The caller initializes the state like
+ * for lowzip_inflate_raw(), except that input must be provided using the
+ * input window.
  */
+void lowzip_inflate_init(lowzip_state *st) {
+	st->input_carry = 0;
+	lowzip_inflate_start(st);
+}
 
-static unsigned int lowzip_zip_crc32(unsigned char *p_start, unsigned char *p_end) {
-	unsigned int crc = 0xffffffffUL;
-	int i;
+/* Continue a resumable raw inflate with the current input window.  Returns
+ * LOWZIP_INFLATE_DONE when the final block has been decoded, and
+ * LOWZIP_INFLATE_ERROR (also setting st->have_error) for errors.
+ *
+ * If input runs out with st->input_more set, decoding rolls back to the
+ * start of the incomplete symbol and LOWZIP_INFLATE_NEED_INPUT is returned.
+ * The caller then updates the input window so that it starts at or before
+ * st->read_offset, and calls again.  When streaming, output decoded so far
+ * has been passed to the output callback.
+ */
+int lowzip_inflate_resume(lowzip_state *st) {
+	if (st->have_error) {
+		return LOWZIP_INFLATE_ERROR;
+	}
 
-	while (p_start < p_end) {
-		crc ^= (unsigned int) (*p_start++);
-		for (i = 0; i < 8; i++) {
-			if (crc & 0x01UL) {
-				crc = (crc >> 1U) ^ 0xedb88320UL;
-			} else {
-				crc = (crc >> 1U);
+	st->need_input = 0;
+	lowzip_inflate_run(st);
+
+	if (st->need_input) {
+		st->need_input = 0;
+		st->have_error = 0;
+		lowzip_rollback(st);
+	}
+#if defined(LOWZIP_STREAMING)
+	if (st->write_callback && !st->have_error) {
+		lowzip_flush_output(st);
+	}
+#endif
+
+	if (st->have_error) {
+		return LOWZIP_INFLATE_ERROR;
+	}
+	return st->mode == LOWZIP_MODE_DONE ? LOWZIP_INFLATE_DONE : LOWZIP_INFLATE_NEED_INPUT;
+}
+
+/* Continue a raw inflate with input from st->next_in/st->avail_in, which
+ * is decoded directly using it as the input window.  Offsets stay relative
+ * to the whole input: st->read_offset is where st->next_in (or the carried
+ * bytes before it) begins.
+ *
+ * When input runs out mid-symbol, the remaining bytes are copied to
+ * st->input_buf.  On the next call they're stitched together with the
+ * start of the new input in st->input_buf until decoding gets past them,
+ * then decoding continues directly from st->next_in.  A symbol or header
+ * needs at most about 10 bytes, so the carried bytes always fit.
+ */
+int lowzip_inflate_push(lowzip_state *st, int finish) {
+	unsigned int chunk_start;
+	unsigned int end;
+	unsigned int n;
+	int carried;
+	int rc;
+
+	st->read_callback = NULL;  /* All input comes from the window. */
+	st->read_span_callback = NULL;
+
+	for (;;) {
+		carried = st->input_carry > 0;
+		if (carried) {
+			/* Stitch carried bytes and new input in input_buf. */
+			n = (unsigned int) sizeof(st->input_buf) - st->input_carry;
+			if (n > st->avail_in) {
+				n = st->avail_in;
+			}
+			memcpy((void *) (st->input_buf + st->input_carry), (const void *) st->next_in, n);
+			st->input_data = st->input_buf;
+			st->input_length = st->input_carry + n;
+			st->input_more = !finish || n < st->avail_in;
+		} else {
+			n = st->avail_in;
+			st->input_data = st->next_in;
+			st->input_length = n;
+			st->input_more = !finish;
+		}
+		st->input_offset = st->read_offset;
+		chunk_start = st->read_offset + st->input_carry;  /* Offset of next_in[0]. */
+
+		rc = lowzip_inflate_resume(st);
+
+		/* Consume new input up to the read offset.  At the end of the
+		 * stream, whole bytes loaded ahead into the bit buffer aren't
+		 * part of the stream.
+		 */
+		end = st->read_offset;
+		if (rc == LOWZIP_INFLATE_DONE) {
+			end -= st->have >> 3U;
+		}
+		if (end > chunk_start) {
+			st->next_in += end - chunk_start;
+			st->avail_in -= end - chunk_start;
+		}
+		if (rc != LOWZIP_INFLATE_NEED_INPUT) {
+			st->input_carry = 0;
+			return rc;
+		}
+
+		if (st->read_offset >= chunk_start) {
+			/* Past any carried bytes. */
+			st->input_carry = 0;
+			if (carried) {
+				continue;  /* Decode directly from next_in. */
+			}
+
+			/* Carry the incomplete tail of next_in. */
+			if (st->avail_in > sizeof(st->input_buf)) {
+				break;
 			}
+			memcpy((void *) st->input_buf, (const void *) st->next_in, st->avail_in);
+			st->input_carry = st->avail_in;
+			st->next_in += st->avail_in;
+			st->avail_in = 0;
+			return LOWZIP_INFLATE_NEED_INPUT;
+		}
+
+		/* Still inside the carried bytes, so the stitched new input
+		 * was all needed: carry it too.
+		 */
+		st->input_carry = st->input_length - (st->read_offset - st->input_offset);
+		memmove((void *) st->input_buf, (const void *) (st->input_buf + (st->read_offset - st->input_offset)), st->input_carry);
+		st->next_in += n;
+		st->avail_in -= n;
+		if (st->avail_in == 0) {
+			return LOWZIP_INFLATE_NEED_INPUT;
+		}
+		if (st->input_carry >= sizeof(st->input_buf)) {
+			break;
 		}
 	}
 
-	return crc ^ 0xffffffffUL;
+	/* Incomplete symbol larger than input_buf, cannot happen. */
+	st->have_error = 1;
+	return LOWZIP_INFLATE_ERROR;
 }
+#endif  /* LOWZIP_RESUMABLE */
+
+/*
+ *  Speculative decoding
+ */
+
+#if defined(LOWZIP_SPECULATIVE)
+
+/* Compare input positions: -1, 0 or 1 if 'a' is before, at or after 'b'. */
+static int lowzip_bitpos_compare(const lowzip_bitpos *a, const lowzip_bitpos *b) {
+	if (a->offset != b->offset) {
+		return a->offset < b->offset ? -1 : 1;
+	}
+	/* More unread bits of the preceding byte is an earlier position. */
+	return a->bits > b->bits ? -1 : (a->bits < b->bits ? 1 : 0);
+}
+
+/* Current input position, with whole bytes in the bit buffer re-read. */
+static void lowzip_get_bitpos(lowzip_state *st, lowzip_bitpos *pos) {
+	pos->offset = st->read_offset - (st->have >> 3U);
+	pos->bits = st->have & 0x07U;
+}
+
+/* Continue decoding from input position 'pos', at a block header. */
+static void lowzip_set_bitpos(lowzip_state *st, const lowzip_bitpos *pos) {
+	unsigned int x;
+
+	lowzip_reset_bitstate(st);
+	st->read_offset = pos->offset;
+	st->mode = LOWZIP_MODE_HEADER;
+	if (pos->bits > 0) {
+		x = lowzip_read_input(st, pos->offset - 1);
+		if (x & 0x100U) {
+			st->have_error = 1;
+		}
+		st->curr = (x & 0xffU) >> (8U - pos->bits);
+		st->have = pos->bits;
+	}
+}
+
+/* Check that Huffman code lengths form a complete code, or for distances
+ * also a single one bit code or no codes, like encoders produce.  The
+ * decoder accepts incomplete codes; this is only used to reject false
+ * block starts early.
+ */
+static int lowzip_code_lens_complete(const unsigned char *code_lens, unsigned int count, int distance) {
+	unsigned int i;
+	unsigned int sum;
+	unsigned int used;
+
+	sum = 0;
+	used = 0;
+	for (i = 0; i < count; i++) {
+		if (code_lens[i] > 0) {
+			sum += 32768U >> code_lens[i];  /* Lengths are at most 15. */
+			used++;
+		}
+	}
+	return sum == 32768U || (distance && used <= 1 && sum <= 16384U);
+}
+
+/* Copy uncompressed block data into chunk symbols.  Returns non-zero if
+ * the symbol buffer is full.
+ */
+static int lowzip_decode_stored_symbols(lowzip_state *st, lowzip_chunk *ch) {
+	while (st->block_remain > 0) {
+		if (st->have_error) {
+			return 0;
+		}
+		if (ch->symbols_length >= ch->symbols_size) {
+			return 1;
+		}
+		ch->symbols[ch->symbols_length++] = (unsigned short) lowzip_read_bits(st, 8);
+		st->block_remain--;
+	}
+	return 0;
+}
+
+/* Decode Huffman block data into chunk symbols.  Back-references copy
+ * symbols, so placeholders for window bytes propagate.  Returns non-zero
+ * if the symbol buffer is too full for the next symbol, which is then
+ * decoded on the next call.
+ */
+static int lowzip_decode_symbols(lowzip_state *st, lowzip_chunk *ch, int static_huffman) {
+	unsigned short *out;
+	unsigned short *out_end;
+	unsigned int pos;
+	unsigned int t;
+	unsigned int back_len;
+	unsigned int back_dist;
+
+	out = ch->symbols + ch->symbols_length;
+	out_end = ch->symbols + ch->symbols_size;
+	for (;;) {
+		if (st->have_error) {
+			break;
+		}
+		if (out_end - out < 258) {
+			ch->symbols_length = (unsigned int) (out - ch->symbols);
+			return 1;
+		}
+
+		t = lowzip_decode_lit_symbol(st, static_huffman);
+		if (t < 256) {
+			*out++ = (unsigned short) t;
+		} else if (t == 256) {
+			break;
+		} else {
+			if (t > 285) {
+				goto format_error;
+			}
+			t -= 257;
+			back_len = (unsigned int) lowzip_len_base[t] + 3U + lowzip_read_bits(st, lowzip_len_bits[t]);
+
+			t = lowzip_decode_dist_symbol(st, static_huffman);
+			if (t > 29) {
+				goto format_error;
+			}
+			back_dist = lowzip_dist_base[t] + lowzip_read_bits(st, lowzip_dist_bits[t]);
+
+			pos = (unsigned int) (out - ch->symbols);
+			if (back_dist > pos + ch->window_length) {
+				goto format_error;
+			}
+			while (back_len-- > 0) {
+				if (back_dist > pos) {
+					*out = (unsigned short) (LOWZIP_SYMBOL_WINDOW + 32768U - (back_dist - pos));
+				} else {
+					*out = *(out - back_dist);
+				}
+				out++;
+				pos++;
+			}
+		}
+	}
+	ch->symbols_length = (unsigned int) (out - ch->symbols);
+	return 0;
+
+ format_error:
+	ch->symbols_length = (unsigned int) (out - ch->symbols);
+	st->have_error = 1;
+	return 0;
+}
+
+/* Block level loop of speculative decoding, like lowzip_inflate_run().
+ * With 'first_block' set (searching for a chunk start), Huffman codes are
+ * checked strictly and decoding stops after the first block.
+ */
+static int lowzip_chunk_run(lowzip_state *st, lowzip_chunk *ch, int first_block) {
+	unsigned char *code_lens;
+	unsigned int blockhdr;
+	int blocks;
+
+	blocks = 0;
+	for (;;) {
+		if (st->have_error) {
+			return LOWZIP_INFLATE_ERROR;
+		}
+
+		switch (st->mode) {
+		case LOWZIP_MODE_HEADER:
+			lowzip_get_bitpos(st, &ch->end);
+			if (first_block && blocks > 0) {
+				return LOWZIP_INFLATE_DONE;
+			}
+			while (ch->next_stop < ch->num_stops &&
+			       lowzip_bitpos_compare(ch->stops + ch->next_stop, &ch->end) < 0) {
+				ch->next_stop++;
+			}
+			if (ch->next_stop < ch->num_stops &&
+			    lowzip_bitpos_compare(ch->stops + ch->next_stop, &ch->end) == 0) {
+				ch->stop_index = (int) ch->next_stop;
+				return LOWZIP_INFLATE_DONE;
+			}
+
+			blocks++;
+			blockhdr = lowzip_read_bits(st, 3);
+			st->block_final = blockhdr & 0x01U;
+			switch (blockhdr >> 1U) {
+			case 0:
+				st->mode = LOWZIP_MODE_STORED_LEN;
+				break;
+			case 1:
+				st->mode = LOWZIP_MODE_STATIC;
+				break;
+			case 2:
+				st->mode = LOWZIP_MODE_TABLE;
+				break;
+			default:
+				st->have_error = 1;
+				break;
+			}
+			break;
+		case LOWZIP_MODE_STORED_LEN:
+			lowzip_decode_stored_header(st);
+			break;
+		case LOWZIP_MODE_STORED_COPY:
+			if (lowzip_decode_stored_symbols(st, ch)) {
+				return LOWZIP_INFLATE_NEED_OUTPUT;
+			}
+			if (!st->have_error) {
+				st->mode = st->block_final ? LOWZIP_MODE_DONE : LOWZIP_MODE_HEADER;
+			}
+			break;
+		case LOWZIP_MODE_TABLE:
+			lowzip_decode_dynamic_huffman_table(st);
+			code_lens = (unsigned char *) st->scratch + sizeof(st->scratch) - 320 - 19;
+			if (first_block && !st->have_error && !lowzip_code_lens_complete(code_lens, 19, 0)) {
+				st->have_error = 1;
+			}
+			break;
+		case LOWZIP_MODE_CODELENS:
+			lowzip_decode_dynamic_huffman_code_lengths(st);
+			code_lens = (unsigned char *) st->scratch + sizeof(st->scratch) - 320;
+			if (first_block && !st->have_error &&
+			    (!lowzip_code_lens_complete(code_lens, st->nlit, 0) ||
+			     !lowzip_code_lens_complete(code_lens + st->nlit, st->ndist, 1))) {
+				st->have_error = 1;
+			}
+			break;
+		case LOWZIP_MODE_STATIC:
+		case LOWZIP_MODE_DYNAMIC:
+			if (lowzip_decode_symbols(st, ch, st->mode == LOWZIP_MODE_STATIC)) {
+				return LOWZIP_INFLATE_NEED_OUTPUT;
+			}
+			if (!st->have_error) {
+				st->mode = st->block_final ? LOWZIP_MODE_DONE : LOWZIP_MODE_HEADER;
+			}
+			break;
+		default:
+			/* LOWZIP_MODE_DONE. */
+			lowzip_get_bitpos(st, &ch->end);
+			ch->stop_index = -1;
+			return LOWZIP_INFLATE_DONE;
+		}
+	}
+}
+
+/* Reset chunk output for decoding from 'pos'. */
+static void lowzip_reset_chunk(lowzip_state *st, lowzip_chunk *ch, const lowzip_bitpos *pos, unsigned int window_length) {
+	st->have_error = 0;
+	lowzip_set_bitpos(st, pos);
+	ch->start = *pos;
+	ch->end = *pos;
+	ch->symbols_length = 0;
+	ch->window_length = window_length;
+	ch->next_stop = 0;
+	ch->stop_index = -1;
+}
+
+void lowzip_start_chunk(lowzip_state *st, lowzip_chunk *ch) {
+	lowzip_bitpos pos;
+
+	pos.offset = st->read_offset;
+	pos.bits = 0;
+	lowzip_reset_chunk(st, ch, &pos, 0);
+}
+
+int lowzip_find_chunk(lowzip_state *st, lowzip_chunk *ch, unsigned int offset, unsigned int end) {
+	lowzip_bitpos pos;
+	unsigned int bit;
+	unsigned int hdr;
+
+	for (; offset < end; offset++) {
+		for (bit = 0; bit < 8; bit++) {
+			/* Candidate block header starting at bit 'bit' of
+			 * byte 'offset'.
+			 */
+			pos.offset = offset + (bit > 0 ? 1U : 0U);
+			pos.bits = (8U - bit) & 0x07U;
+
+			/* Quick check of BFINAL=0, BTYPE=2 and the table
+			 * sizes (HLIT and HDIST at most 29 in valid input).
+			 */
+			lowzip_reset_chunk(st, ch, &pos, 32768U);
+			hdr = lowzip_read_bits(st, 13);
+			if (st->have_error || (hdr & 0x07U) != 0x04U ||
+			    ((hdr >> 3U) & 0x1fU) > 29 || (hdr >> 8U) > 29) {
+				continue;
+			}
+
+			lowzip_reset_chunk(st, ch, &pos, 32768U);
+			if (lowzip_chunk_run(st, ch, 1) != LOWZIP_INFLATE_DONE) {
+				continue;
+			}
+			hdr = lowzip_read_bits(st, 3);
+			if (st->have_error || (hdr >> 1U) == 3) {
+				continue;
+			}
+			lowzip_set_bitpos(st, &ch->end);
+			return 1;
+		}
+	}
+	st->have_error = 0;
+	return 0;
+}
+
+int lowzip_inflate_chunk(lowzip_state *st, lowzip_chunk *ch) {
+	return lowzip_chunk_run(st, ch, 0);
+}
+
+int lowzip_resolve_chunk(const lowzip_chunk *ch, unsigned int first, unsigned int count,
+                         const unsigned char *window, unsigned int window_length, unsigned char *out) {
+	const unsigned short *p;
+	unsigned int skip;
+	unsigned int i;
+	unsigned int t;
+
+	p = ch->symbols + first;
+	skip = 32768U - window_length;
+	for (i = 0; i < count; i++) {
+		t = p[i];
+		if (t < LOWZIP_SYMBOL_WINDOW) {
+			out[i] = (unsigned char) t;
+		} else {
+			t -= LOWZIP_SYMBOL_WINDOW;
+			if (t < skip) {
+				return 1;
+			}
+			out[i] = window[t - skip];
+		}
+	}
+	return 0;
+}
+#endif  /* LOWZIP_SPECULATIVE */
 
 /*
  *  ZIP operations
  */
 
+/* Check whether the central directory entry at 'offset' has filename
+ * 'name' (of 'name_length' bytes).
+ */
+static int lowzip_match_filename(lowzip_state *st, unsigned int offset, const char *name, size_t name_length) {
+	unsigned int filename_length;
+	unsigned int i;
+	unsigned int t;
+	const unsigned char *p;
+
+	filename_length = lowzip_read2(st, offset + 28);
+	if (filename_length != name_length) {
+		return 0;
+	}
+	p = lowzip_input_span(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH, filename_length);
+	if (p) {
+		return memcmp((const void *) p, (const void *) name, name_length) == 0;
+	}
+	for (i = 0; i < filename_length; i++) {
+		t = lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i);
+		if (t != (unsigned int) ((const unsigned char *) name)[i]) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Offset of the central directory entry following the one at 'offset'. */
+static unsigned int lowzip_next_central_entry(lowzip_state *st, unsigned int offset) {
+	unsigned int t;
+
+	t = lowzip_read2(st, offset + 28);   /* filename length */
+	t += lowzip_read2(st, offset + 30);  /* extra length */
+	t += lowzip_read2(st, offset + 32);  /* comment length */
+	return offset + LOWZIP_MIN_CDIRFILE_LENGTH + t;
+}
+
+/* Copy the filename of the central directory entry at 'offset' into 'fi',
+ * truncated to fit.
+ */
+static void lowzip_copy_filename(lowzip_state *st, unsigned int offset, lowzip_file *fi) {
+	unsigned int filename_length;
+	unsigned int i, n;
+
+	filename_length = lowzip_read2(st, offset + 28);
+	fi->filename_length = filename_length;
+	n = filename_length > sizeof(fi->filename) - 1 ? sizeof(fi->filename) - 1 : filename_length;
+	for (i = 0; i < n; i++) {
+		fi->filename[i] = (char) lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i);
+	}
+	fi->filename[n] = 0;
+}
+
+/* Make the file of the central directory entry at 'offset' the "current
+ * file": parse its local file header into the lowzip_file struct in the
+ * scratch area.  Returns NULL (and sets st->have_error) if the local file
+ * header is corrupt.
+ */
+static lowzip_file *lowzip_select_file(lowzip_state *st, unsigned int offset) {
+	unsigned int t;
+	unsigned int lhdr_offset;
+	lowzip_file *fi;
+
+	/* Store the local file header offset as the "current file" in the
+	 * lowzip state.  File info queries and content reading will parse
+	 * the local file header which duplicates most of the central
+	 * directory fields.
+	 */
+	lhdr_offset = lowzip_read4(st, offset + 42);
+
+	t = lowzip_read4(st, lhdr_offset);
+	if (t != 0x04034b50UL) {
+		/* Local file header corrupt. */
+		st->have_error = 1;
+		return NULL;
+	}
+
+	fi = (lowzip_file *) st->scratch;
+
+	fi->compression_method = lowzip_read2(st, lhdr_offset + 8);
+	fi->crc32 = lowzip_read4(st, lhdr_offset + 14);
+	fi->compressed_size = lowzip_read4(st, lhdr_offset + 18);
+	fi->uncompressed_size = lowzip_read4(st, lhdr_offset + 22);
+	t = lowzip_read2(st, lhdr_offset + 26);
+	t += lowzip_read2(st, lhdr_offset + 28);
+	fi->data_offset = lhdr_offset + LOWZIP_MIN_LOCFILE_LENGTH + t;
+	fi->local_header_offset = lhdr_offset;
+	lowzip_copy_filename(st, offset, fi);
+
+	/* 'fi' is valid for current file until the file data is read; that
+	 * may involve inflating which overwrites the scratch area.
+	 */
+	return fi;
+}
+
+#if defined(LOWZIP_ITERATOR)
+/* Start iterating over central directory entries. */
+void lowzip_iter_begin(lowzip_state *st, lowzip_iter *it) {
+	it->entry_offset = 0;
+	it->next_offset = st->central_dir_offset;
+	it->index = 0;
+}
+
+/* Return info for the next central directory entry, or NULL at the end. */
+lowzip_file *lowzip_iter_next(lowzip_state *st, lowzip_iter *it) {
+	unsigned int offset;
+	lowzip_file *fi;
+
+	st->have_error = 0;
+	offset = it->next_offset;
+	if (lowzip_read4(st, offset) != 0x02014b50UL) {
+		return NULL;  /* End of directory (or read error). */
+	}
+
+	fi = (lowzip_file *) st->scratch;
+	fi->compression_method = lowzip_read2(st, offset + 10);
+	fi->crc32 = lowzip_read4(st, offset + 16);
+	fi->compressed_size = lowzip_read4(st, offset + 20);
+	fi->uncompressed_size = lowzip_read4(st, offset + 24);
+	fi->local_header_offset = lowzip_read4(st, offset + 42);
+	fi->data_offset = 0;
+	lowzip_copy_filename(st, offset, fi);
+	if (st->have_error) {
+		return NULL;
+	}
+
+	it->entry_offset = offset;
+	it->next_offset = lowzip_next_central_entry(st, offset);
+	it->index++;
+	return fi;
+}
+
+/* Make the entry most recently returned by lowzip_iter_next() the current
+ * file, like lowzip_locate_file().
+ */
+lowzip_file *lowzip_iter_locate(lowzip_state *st, const lowzip_iter *it) {
+	st->have_error = 0;
+	if (it->entry_offset == 0) {
+		st->have_error = 1;
+		return NULL;
+	}
+	return lowzip_select_file(st, it->entry_offset);
+}
+#endif  /* LOWZIP_ITERATOR */
+
+#if defined(LOWZIP_NAME_INDEX)
+/* Filename hash for the name index (32-bit FNV-1a), one byte at a time. */
+static unsigned int lowzip_hash_name_byte(unsigned int h, unsigned int ch) {
+	return ((h ^ ch) * 16777619UL) & 0xffffffffUL;
+}
+
+#define LOWZIP_HASH_NAME_INIT  2166136261UL
+
+/* Hash of the filename of the central directory entry at 'offset'. */
+static unsigned int lowzip_hash_entry_name(lowzip_state *st, unsigned int offset) {
+	unsigned int filename_length;
+	unsigned int h;
+	unsigned int i;
+	const unsigned char *p;
+
+	filename_length = lowzip_read2(st, offset + 28);
+	h = LOWZIP_HASH_NAME_INIT;
+	p = lowzip_input_span(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH, filename_length);
+	for (i = 0; i < filename_length; i++) {
+		h = lowzip_hash_name_byte(h, p ? (unsigned int) p[i] : lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i));
+	}
+	return h;
+}
+
+/* Hash of a NUL terminated name, 'name_length' is set to its length. */
+static unsigned int lowzip_hash_name(const char *name, size_t *name_length) {
+	const unsigned char *p;
+	unsigned int h;
+
+	h = LOWZIP_HASH_NAME_INIT;
+	for (p = (const unsigned char *) name; *p; p++) {
+		h = lowzip_hash_name_byte(h, (unsigned int) *p);
+	}
+	*name_length = (size_t) (p - (const unsigned char *) name);
+	return h;
+}
+
+/* Build an in-RAM filename hash index in one central directory pass, see
+ * lowzip.h.  The table uses open addressing with linear probing; slots
+ * with a zero offset are empty (a central directory entry is never at
+ * offset zero because a local file header precedes it).  If the table
+ * fills up, st->have_error is set and lookups keep scanning linearly.
+ */
+void lowzip_build_name_index(lowzip_state *st, lowzip_name_entry *table, unsigned int size) {
+	unsigned int offset;
+	unsigned int count;
+	unsigned int h;
+	unsigned int i;
+
+	st->have_error = 0;
+	st->name_index = NULL;
+	st->name_index_size = 0;
+	if (size == 0) {
+		goto fail;
+	}
+	memset((void *) table, 0, sizeof(lowzip_name_entry) * size);
+
+	count = 0;
+	offset = st->central_dir_offset;
+	while (lowzip_read4(st, offset) == 0x02014b50UL) {
+		if (++count >= size || offset == 0) {
+			goto fail;  /* Keep one slot empty to terminate probing. */
+		}
+
+		h = lowzip_hash_entry_name(st, offset);
+		i = h % size;
+		while (table[i].offset != 0) {
+			i = (i + 1 == size ? 0 : i + 1);
+		}
+		table[i].hash = h;
+		table[i].offset = offset;
+
+		offset = lowzip_next_central_entry(st, offset);
+	}
+	if (st->have_error) {
+		goto fail;
+	}
+
+	st->name_index = table;
+	st->name_index_size = size;
+	return;
+
+ fail:
+	st->have_error = 1;
+}
+
+/* Look up 'count' names in one central directory pass, see lowzip.h.  The
+ * names are hashed into 'table' like the name index, except that slot
+ * 'offset' is the index of the name plus one.  Each central directory
+ * filename is hashed once and probed; the pass ends early once every
+ * name has been found.  Like lowzip_locate_file() the first entry with a
+ * name wins.
+ */
+unsigned int lowzip_locate_files(lowzip_state *st, const char * const *names, unsigned int count,
+                                 lowzip_entry *entries, lowzip_name_entry *table, unsigned int size) {
+	lowzip_entry *e;
+	unsigned int offset;
+	unsigned int found;
+	unsigned int h;
+	unsigned int i;
+	unsigned int j;
+	size_t name_length;
+
+	st->have_error = 0;
+	if (count == 0) {
+		return 0;  /* Empty batch, 'entries' and 'table' may be NULL. */
+	}
+	memset((void *) entries, 0, sizeof(lowzip_entry) * count);
+	if (count >= size) {
+		goto fail;  /* Keep one slot empty to terminate probing. */
+	}
+	memset((void *) table, 0, sizeof(lowzip_name_entry) * size);
+	for (j = 0; j < count; j++) {
+		h = lowzip_hash_name(names[j], &name_length);
+		i = h % size;
+		while (table[i].offset != 0) {
+			i = (i + 1 == size ? 0 : i + 1);
+		}
+		table[i].hash = h;
+		table[i].offset = j + 1;
+	}
+
+	found = 0;
+	offset = st->central_dir_offset;
+	while (found < count && lowzip_read4(st, offset) == 0x02014b50UL) {
+		h = lowzip_hash_entry_name(st, offset);
+		for (i = h % size; table[i].offset != 0; i = (i + 1 == size ? 0 : i + 1)) {
+			j = table[i].offset - 1;
+			e = entries + j;
+			if (table[i].hash != h || e->offset != 0 ||
+			    !lowzip_match_filename(st, offset, names[j], strlen(names[j]))) {
+				continue;
+			}
+			e->offset = offset;
+			e->compression_method = lowzip_read2(st, offset + 10);
+			e->crc32 = lowzip_read4(st, offset + 16);
+			e->compressed_size = lowzip_read4(st, offset + 20);
+			e->uncompressed_size = lowzip_read4(st, offset + 24);
+			e->local_header_offset = lowzip_read4(st, offset + 42);
+			found++;
+		}
+		offset = lowzip_next_central_entry(st, offset);
+	}
+	if (st->have_error) {
+		goto fail;
+	}
+	return found;
+
+ fail:
+	memset((void *) entries, 0, sizeof(lowzip_entry) * count);
+	st->have_error = 1;
+	return 0;
+}
+
+/* Make the file of an entry found by lowzip_locate_files() the current
+ * file, like lowzip_locate_file().
+ */
+lowzip_file *lowzip_locate_entry(lowzip_state *st, const lowzip_entry *e) {
+	st->have_error = 0;
+	if (e->offset == 0) {
+		st->have_error = 1;
+		return NULL;
+	}
+	return lowzip_select_file(st, e->offset);
+}
+#endif  /* LOWZIP_NAME_INDEX */
+
+#if defined(LOWZIP_OFFSET_TABLE)
+/* Build a central directory offset table in one pass, see lowzip.h. */
+void lowzip_build_offset_table(lowzip_state *st, unsigned int *table, unsigned int size) {
+	unsigned int offset;
+	unsigned int count;
+
+	st->have_error = 0;
+	st->entry_offsets = NULL;
+
+	count = 0;
+	offset = st->central_dir_offset;
+	while (lowzip_read4(st, offset) == 0x02014b50UL) {
+		if (count >= size) {
+			break;
+		}
+		table[count++] = offset;
+		offset = lowzip_next_central_entry(st, offset);
+	}
+	if (st->have_error) {
+		return;
+	}
+
+	st->entry_offsets = table;
+	st->entry_offsets_count = count;
+	st->entry_offsets_complete = (count < size);
+}
+#endif  /* LOWZIP_OFFSET_TABLE */
+
 /* Scan central directory for a file by index or name.  If found, return a
  * lowzip_file struct pointer.  The struct is allocated from a shared scratch
  * area in 'st' and is invalidated by another lowzip_locate_file() or a
  * lowzip_get_data() operation.  If file is not found, returns NULL and sets
  * st->have_error.
+ *
+ * With a name index, a lookup by name is a hash probe and a filename check
+ * instead of a scan.  With an offset table, a lookup by index starts from
+ * the table entry instead.
  */
 lowzip_file *lowzip_locate_file(lowzip_state *st, int idx, const char *name) {
 	unsigned int offset;
-	unsigned int t;
-	unsigned int filename_length;
-	unsigned int i, n;
-	unsigned int lhdr_offset;
-	int found = 0;
-	lowzip_file *fi;
+#if defined(LOWZIP_NAME_INDEX)
+	unsigned int h;
+	unsigned int i;
+#endif
 	size_t name_length = 0;
 
 	st->have_error = 0;
@@ -807,7 +3385,37 @@ lowzip_file *lowzip_locate_file(lowzip_state *st, int idx, const char *name) {
 		name_length = strlen(name);
 	}
 
+#if defined(LOWZIP_NAME_INDEX)
+	if (name && st->name_index) {
+		h = lowzip_hash_name(name, &name_length);
+		i = h % st->name_index_size;
+		while (st->name_index[i].offset != 0) {
+			if (st->name_index[i].hash == h &&
+			    lowzip_match_filename(st, st->name_index[i].offset, name, name_length)) {
+				return lowzip_select_file(st, st->name_index[i].offset);
+			}
+			i = (i + 1 == st->name_index_size ? 0 : i + 1);
+		}
+		st->have_error = 1;
+		return NULL;
+	}
+#endif
+
 	offset = st->central_dir_offset;
+#if defined(LOWZIP_OFFSET_TABLE)
+	if (!name && idx >= 0 && st->entry_offsets && st->entry_offsets_count > 0) {
+		if ((unsigned int) idx < st->entry_offsets_count) {
+			return lowzip_select_file(st, st->entry_offsets[idx]);
+		}
+		if (st->entry_offsets_complete) {
+			st->have_error = 1;
+			return NULL;
+		}
+		offset = st->entry_offsets[st->entry_offsets_count - 1];
+		idx -= (int) st->entry_offsets_count - 1;
+	}
+#endif
+
 	for (;;) {
 		if (lowzip_read4(st, offset) != 0x02014b50UL) {
 			/* Magic no longer matches, assume end of directory.
@@ -822,79 +3430,10 @@ lowzip_file *lowzip_locate_file(lowzip_state *st, int idx, const char *name) {
 			break;
 		}
 
-		filename_length = lowzip_read2(st, offset + 28);
-#if 0
-		fprintf(stderr, "[");
-		for (i = 0; i < filename_length; i++) {
-			t = lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i);
-			fprintf(stderr, "%c", (int) t);
-		}
-		fprintf(stderr, "]\n");
-		fflush(stderr);
-#endif
-		if (name) {
-			if (filename_length == name_length) {
-				for (i = 0; i < filename_length; i++) {
-					t = lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i);
-					if (t != (unsigned int) ((unsigned char *) name)[i]) {
-						break;
-					}
-				}
-				if (i == filename_length) {
-					found = 1;
-				}
-			}
-		} else {
-			if (idx == 0) {
-				found = 1;
-			}
-			idx--;
+		if (name ? lowzip_match_filename(st, offset, name, name_length) : idx-- == 0) {
+			return lowzip_select_file(st, offset);
 		}
-
-		if (!found) {
-			t = filename_length;
-			t += lowzip_read2(st, offset + 30);  /* extra length */
-			t += lowzip_read2(st, offset + 32);  /* comment length */
-			offset += LOWZIP_MIN_CDIRFILE_LENGTH + t;
-			continue;
-		}
-
-		/* Matching entry found.  Store the local file header offset
-		 * as the "current file" in the lowzip state.  File info
-		 * queries and content reading will parse the local file
-		 * header which duplicates most of the central directory
-		 * fields.
-		 */
-		lhdr_offset = lowzip_read4(st, offset + 42);
-
-		t = lowzip_read4(st, lhdr_offset);
-		if (t != 0x04034b50UL) {
-			/* Local file header corrupt. */
-			break;
-		}
-
-		fi = (lowzip_file *) st->scratch;
-
-		fi->compression_method = lowzip_read2(st, lhdr_offset + 8);
-		fi->crc32 = lowzip_read4(st, lhdr_offset + 14);
-		fi->compressed_size = lowzip_read4(st, lhdr_offset + 18);
-		fi->uncompressed_size = lowzip_read4(st, lhdr_offset + 22);
-		t = lowzip_read2(st, lhdr_offset + 26);
-		t += lowzip_read2(st, lhdr_offset + 28);
-		fi->data_offset = lhdr_offset + LOWZIP_MIN_LOCFILE_LENGTH + t;
-
-		n = filename_length > sizeof(fi->filename) - 1 ? sizeof(fi->filename) - 1 : filename_length;
-		for (i = 0; i < n; i++) {
-			t = lowzip_read1(st, offset + LOWZIP_MIN_CDIRFILE_LENGTH + i);
-			fi->filename[i] = (unsigned char) t;
-		}
-		fi->filename[n] = 0;
-
-		/* 'fi' is valid for current file until the file data is
-		 * read; that may involve inflating which overwrites the
-		 * scratch area.
-		 */
-		return fi;
+		offset = lowzip_next_central_entry(st, offset);
 	}
 
 	st->have_error = 1;
@@ -918,38 +3457,165 @@ lowzip_file *lowzip_locate_file(lowzip_state *st, int idx, const char *name) {
  * See https://github.com/thejoshwolfe/yauzl/issues/48#issuecomment-266587526.
  */
 void lowzip_init_archive(lowzip_state *st) {
-	int offset;
-	unsigned int cdir_offset;
+	unsigned char *buf;
+	const unsigned char *p;
+	const unsigned char *p_end;
+	const unsigned char *q;
+	unsigned int lo;
+	unsigned int hi;
+	unsigned int start;
+	unsigned int offset;
+	unsigned int eocd_offset;
+	int found;
+
+	st->have_error = 0;
+	if (st->read_span_callback) {
+		st->input_length = 0;  /* Discard buffered input, if any. */
+	}
+#if defined(LOWZIP_NAME_INDEX)
+	st->name_index = NULL;  /* Built for a previous archive, if any. */
+	st->name_index_size = 0;
+#endif
+#if defined(LOWZIP_OFFSET_TABLE)
+	st->entry_offsets = NULL;
+	st->entry_offsets_count = 0;
+	st->entry_offsets_complete = 0;
+#endif
+
+	/* Candidate offsets are [lo,hi], scanned backwards in blocks read
+	 * into the scratch area (unused at this point) with one read per
+	 * block.  An in-memory archive is scanned in place.  Within a block
+	 * memchr() finds candidate 'P' bytes, and the highest valid match
+	 * in the block wins, like a byte-by-byte backwards scan would.
+	 */
+	if (st->zip_length < LOWZIP_MIN_EOCDIR_LENGTH) {
+		goto fail;
+	}
+	hi = st->zip_length - LOWZIP_MIN_EOCDIR_LENGTH;
+	lo = (st->zip_length > LOWZIP_MAX_EOCDIR_LENGTH ? st->zip_length - LOWZIP_MAX_EOCDIR_LENGTH : 0);
+	buf = (unsigned char *) st->scratch;
 
-	st->have_error = 0;
+	for (;;) {
+		start = (hi - lo > sizeof(st->scratch) - 4 ? hi - (sizeof(st->scratch) - 4) : lo);
+		p = NULL;
+		if (!st->read_span_callback) {
+			/* Span read window may be refilled while validating. */
+			p = lowzip_input_span(st, start, hi - start + 4);
+		}
+		if (!p) {
+			lowzip_copy_input(st, start, buf, hi - start + 4);
+			if (st->have_error) {
+				goto fail;
+			}
+			p = buf;
+		}
 
-	/* 'offset' is signed on purpose so that if st->zip_length is very
-	 * small, the loop breaks out immediately.
-	 */
-	for (offset = (int) st->zip_length - LOWZIP_MIN_EOCDIR_LENGTH; offset >= (int) st->zip_length - LOWZIP_MAX_EOCDIR_LENGTH; offset--) {
+		found = 0;
+		p_end = p + (hi - start) + 1;
+		for (q = p; q < p_end; q++) {
+			q = (const unsigned char *) memchr((const void *) q, 0x50, (size_t) (p_end - q));
+			if (!q) {
+				break;
+			}
+			if (q[1] != 0x4bU || q[2] != 0x05U || q[3] != 0x06U) {
+				continue;
+			}
+			offset = start + (unsigned int) (q - p);
+			if (offset + LOWZIP_MIN_EOCDIR_LENGTH + lowzip_read2(st, offset + 20) != st->zip_length) {
+				continue;
+			}
+			found = 1;
+			eocd_offset = offset;
+		}
 		if (st->have_error) {
-			break;
+			goto fail;
 		}
-		if (lowzip_read4(st, offset) != 0x06054b50UL) {
-			continue;
+
+		if (found) {
+			/* Central directory starting offset.  Ignores multiple
+			 * disk ZIP files, i.e. the starting disk number
+			 * (multiple disks are not supported -nor- checked for).
+			 */
+			st->central_dir_offset = lowzip_read4(st, eocd_offset + 16);
+			return;
 		}
-		if (offset + LOWZIP_MIN_EOCDIR_LENGTH + lowzip_read2(st, offset + 20) != st->zip_length) {
-			continue;
+		if (start == lo) {
+			break;
 		}
-
-		/* Central directory starting offset.  Ignores multiple disk
-		 * ZIP files, i.e. the starting disk number (multiple disks
-		 * are not supported -nor- checked for).
-		 */
-		cdir_offset = lowzip_read4(st, offset + 16);
-		st->central_dir_offset = cdir_offset;
-		return;
+		hi = start - 1;
 	}
 
 	/* Not found. */
+ fail:
 	st->have_error = 1;
 }
 
+/* Open a ZIP archive which is in memory (or memory mapped).  The archive is
+ * accessed directly without read callbacks.  The data must remain valid
+ * while the state is in use.  If init fails, st->have_error is set.
+ */
+void lowzip_init_archive_mem(lowzip_state *st, const unsigned char *data, unsigned int length) {
+	st->read_callback = NULL;
+	st->read_span_callback = NULL;
+	st->zip_length = length;
+	st->input_data = data;
+	st->input_offset = 0;
+	st->input_length = length;
+	lowzip_init_archive(st);
+}
+
+#if defined(LOWZIP_SHARED_ARCHIVE)
+/* Export the archive level information of an opened archive for sharing
+ * between threads, see lowzip.h.
+ */
+void lowzip_export_archive(const lowzip_state *st, lowzip_archive *ar) {
+	ar->udata = st->udata;
+	ar->read_callback = st->read_callback;
+	ar->read_span_callback = st->read_span_callback;
+	ar->zip_length = st->zip_length;
+	ar->data = NULL;
+	if (!st->read_callback && !st->read_span_callback) {
+		ar->data = st->input_data;  /* lowzip_init_archive_mem(). */
+	}
+	ar->central_dir_offset = st->central_dir_offset;
+#if defined(LOWZIP_NAME_INDEX)
+	ar->name_index = st->name_index;
+	ar->name_index_size = st->name_index_size;
+#endif
+#if defined(LOWZIP_OFFSET_TABLE)
+	ar->entry_offsets = st->entry_offsets;
+	ar->entry_offsets_count = st->entry_offsets_count;
+	ar->entry_offsets_complete = st->entry_offsets_complete;
+#endif
+}
+
+/* Initialize a per-thread state for a shared archive.  The whole state is
+ * reset; the caller sets up output (and optionally 'udata') afterwards.
+ */
+void lowzip_attach_archive(lowzip_state *st, const lowzip_archive *ar) {
+	memset((void *) st, 0, sizeof(*st));
+	st->udata = ar->udata;
+	st->read_callback = ar->read_callback;
+	st->read_span_callback = ar->read_span_callback;
+	st->zip_length = ar->zip_length;
+	if (ar->data) {
+		st->input_data = ar->data;
+		st->input_offset = 0;
+		st->input_length = ar->zip_length;
+	}
+	st->central_dir_offset = ar->central_dir_offset;
+#if defined(LOWZIP_NAME_INDEX)
+	st->name_index = ar->name_index;
+	st->name_index_size = ar->name_index_size;
+#endif
+#if defined(LOWZIP_OFFSET_TABLE)
+	st->entry_offsets = ar->entry_offsets;
+	st->entry_offsets_count = ar->entry_offsets_count;
+	st->entry_offsets_complete = ar->entry_offsets_complete;
+#endif
+}
+#endif  /* LOWZIP_SHARED_ARCHIVE */
+
 /* Read the data for a file most recently located using lowzip_locate_file().
  * File data can be Store or Deflate compressed.  Getting the data invalidates
  * the lowzip_file struct data returned by lowzip_locate_file().
@@ -965,6 +3631,11 @@ void lowzip_init_archive(lowzip_state *st) {
  *
  * If any error occurs, st->have_error will be set.  The st->output_next
  * pointer may have been advanced, but the data written should be ignored.
+ *
+ * If st->write_callback is set, output is streamed instead: the output
+ * buffer only needs to hold LOWZIP_STREAM_OUTPUT_MIN bytes and file data is
+ * passed to the callback in chunks.  Length and CRC-32 are checked after
+ * the last chunk, so the caller must discard the data if an error occurs.
  */
 void lowzip_get_data(lowzip_state *st) {
 	lowzip_file *fi;
@@ -973,9 +3644,11 @@ void lowzip_get_data(lowzip_state *st) {
 	unsigned int offset_end;
 	unsigned int header_crc32;
 	unsigned int header_uncompressed_size;
-	unsigned int computed_crc32;
 
 	st->have_error = 0;
+	st->crc32 = 0xffffffffUL;
+	st->crc_next = st->output_next;
+	lowzip_init_output(st);
 
 	fi = (lowzip_file *) st->scratch;
 	header_crc32 = fi->crc32;
@@ -984,37 +3657,586 @@ void lowzip_get_data(lowzip_state *st) {
 	if (fi->compression_method == LOWZIP_COMPRESSION_STORE) {
 		offset = fi->data_offset;
 		offset_end = fi->data_offset + fi->uncompressed_size;
-		for (; offset < offset_end; offset++) {
+		while (offset < offset_end) {
+			/* Copy directly into the output buffer.  When
+			 * streaming, each chunk is limited to the space
+			 * left in the output window.
+			 */
+			if (!lowzip_reserve_output(st, 1)) {
+				goto fail;
+			}
+			t = offset_end - offset;
+			if ((ptrdiff_t) t > (ptrdiff_t) (st->output_end - st->output_next)) {
+				t = (unsigned int) (st->output_end - st->output_next);
+			}
+			lowzip_copy_input(st, offset, st->output_next, t);
 			if (st->have_error) {
 				goto fail;
 			}
-			t = lowzip_read1(st, offset);
-			lowzip_write_byte(st, (unsigned char) t);
+			st->output_next += t;
+			offset += t;
 		}
 	} else if (fi->compression_method == LOWZIP_COMPRESSION_DEFLATE) {
 		st->read_offset = fi->data_offset;
-		lowzip_inflate_raw(st);
+		st->mode = LOWZIP_MODE_HEADER;
+		lowzip_reset_bitstate(st);
+		lowzip_inflate_run(st);
 	} else {
 		goto fail;
 	}
 
 	/* Delayed error check. */
 	if (st->have_error) {
-		return;
+		goto fail;
 	}
 
-	/* Minimal validation: output length and CRC32. */
-	if ((ptrdiff_t) (st->output_next - st->output_start) != (ptrdiff_t) header_uncompressed_size) {
+#if defined(LOWZIP_STREAMING)
+	/* Pass the rest of streamed output to the callback. */
+	if (st->write_callback) {
+		lowzip_flush_output(st);
+		if (st->have_error) {
+			goto fail;
+		}
+	}
+#endif
+
+	/* Minimal validation: output length and CRC32.  The CRC32 has been
+	 * computed while producing output, only unflushed Store data (or
+	 * nothing) remains.
+	 */
+	if (lowzip_output_length(st) != header_uncompressed_size) {
 		goto fail;
 	}
-	computed_crc32 = lowzip_zip_crc32(st->output_start, st->output_next);
-	if (computed_crc32 != header_crc32) {
+	lowzip_update_output_crc(st);
+	if ((st->crc32 ^ 0xffffffffUL) != header_crc32) {
 		goto fail;
 	}
 
 	/* All checks out. */
+	st->crc_next = NULL;
+	return;
+
+ fail:
+	st->crc_next = NULL;
+	st->have_error = 1;
+}
+
+/*
+ *  Random access
+ */
+
+#if defined(LOWZIP_RANDOM_ACCESS)
+
+static int lowzip_discard_output(void *udata, const unsigned char *buf, unsigned int length) {
+	(void) udata;
+	(void) buf;
+	(void) length;
+	return 0;
+}
+
+/* Build a checkpoint index for the file most recently located using
+ * lowzip_locate_file(), see lowzip.h.  The whole file is decoded and
+ * checked once using streaming output.  Store entries need no checkpoints.
+ */
+void lowzip_build_index(lowzip_state *st, lowzip_index *idx) {
+	lowzip_file *fi;
+	lowzip_write_callback write_callback;
+
+	fi = (lowzip_file *) st->scratch;
+	idx->num_points = 0;
+	idx->windows_used = 0;
+	idx->compression_method = fi->compression_method;
+	idx->crc32 = fi->crc32;
+	idx->compressed_size = fi->compressed_size;
+	idx->uncompressed_size = fi->uncompressed_size;
+	idx->local_header_offset = fi->local_header_offset;
+	idx->data_offset = fi->data_offset;
+
+	write_callback = st->write_callback;
+	if (!write_callback) {
+		st->write_callback = lowzip_discard_output;
+	}
+	st->index = idx;
+	lowzip_get_data(st);
+	st->index = NULL;
+	st->write_callback = write_callback;
+}
+
+/* Read uncompressed bytes [offset,offset+length[ of an indexed file into
+ * 'buf'.  Decoding starts from the last checkpoint at or before 'offset'
+ * (or the start of the file) with its window preloaded into the output
+ * window, and output is discarded until the range starts.  Decoding stops
+ * when the window fills or at the first block boundary after the range is
+ * complete, whichever comes first.  No CRC-32 check is possible for a
+ * partial read, but decoding errors are detected as usual.
+ */
+void lowzip_read_range(lowzip_state *st, const lowzip_index *idx, unsigned int offset, unsigned char *buf, unsigned int length) {
+	const lowzip_index_point *pt;
+	lowzip_write_callback write_callback;
+	unsigned int lo;
+	unsigned int hi;
+	unsigned int mid;
+
+	st->have_error = 0;
+	if (offset > idx->uncompressed_size || length > idx->uncompressed_size - offset) {
+		goto fail;
+	}
+	if (length == 0) {
+		return;
+	}
+
+	if (idx->compression_method == LOWZIP_COMPRESSION_STORE) {
+		lowzip_copy_input(st, idx->data_offset + offset, buf, length);
+		return;
+	} else if (idx->compression_method != LOWZIP_COMPRESSION_DEFLATE) {
+		goto fail;
+	}
+
+	/* Last checkpoint with out_offset <= offset. */
+	lo = 0;
+	hi = idx->num_points;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2U;
+		if (idx->points[mid].out_offset <= offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	pt = (lo > 0 ? idx->points + lo - 1 : NULL);
+
+	write_callback = st->write_callback;
+	st->write_callback = lowzip_discard_output;
+	st->crc_next = NULL;
+	st->output_next = st->output_start;
+	lowzip_init_output(st);
+	lowzip_reset_bitstate(st);
+	st->read_offset = idx->data_offset;
+	st->range_skip = offset;
+	if (pt && !st->have_error) {
+		memcpy((void *) st->output_next, (const void *) (idx->windows + pt->window_offset), pt->window_length);
+		st->output_next += pt->window_length;
+		st->flush_next = st->output_next;
+		st->read_offset += pt->in_offset;
+		st->curr = pt->bit_value;
+		st->have = pt->bits;
+		st->range_skip = offset - pt->out_offset;
+	}
+	st->range_next = buf;
+	st->range_left = length;
+	st->mode = LOWZIP_MODE_HEADER;
+
+	lowzip_inflate_run(st);
+	if (!st->have_error) {
+		lowzip_flush_output(st);
+	}
+
+	st->range_next = NULL;
+	st->write_callback = write_callback;
+	if (st->range_left == 0) {
+		st->have_error = 0;  /* Stopped when the range was complete. */
+		return;
+	}
+
+ fail:
+	st->have_error = 1;
+}
+
+/* Save a checkpoint index in the format described in lowzip.h.  Windows
+ * are saved back to back, so the saved size is exact.  Returns the saved
+ * size; nothing is written if 'length' is too small.
+ */
+unsigned int lowzip_save_index(const lowzip_index *idx, unsigned char *buf, unsigned int length) {
+	unsigned int hdr[LOWZIP_INDEX_HEADER_SIZE / 4];
+	unsigned int points_size;
+	unsigned int size;
+
+	points_size = idx->num_points * (unsigned int) sizeof(lowzip_index_point);
+	size = LOWZIP_INDEX_HEADER_SIZE + points_size + idx->windows_used;
+	if (!buf || length < size) {
+		return size;
+	}
+
+	hdr[0] = LOWZIP_INDEX_MAGIC;
+	hdr[1] = LOWZIP_INDEX_VERSION;
+	hdr[2] = idx->compression_method;
+	hdr[3] = idx->crc32;
+	hdr[4] = idx->compressed_size;
+	hdr[5] = idx->uncompressed_size;
+	hdr[6] = idx->local_header_offset;
+	hdr[7] = idx->data_offset;
+	hdr[8] = idx->spacing;
+	hdr[9] = idx->num_points;
+	hdr[10] = idx->windows_used;
+	hdr[11] = (unsigned int) sizeof(lowzip_index_point);
+	memcpy((void *) buf, (const void *) hdr, LOWZIP_INDEX_HEADER_SIZE);
+	memcpy((void *) (buf + LOWZIP_INDEX_HEADER_SIZE), (const void *) idx->points, points_size);
+	memcpy((void *) (buf + LOWZIP_INDEX_HEADER_SIZE + points_size), (const void *) idx->windows, idx->windows_used);
+	return size;
+}
+
+/* Load a saved checkpoint index without copying: points and windows are
+ * used in place.  The header is checked against the file most recently
+ * located using lowzip_locate_file() to detect a stale index, and the
+ * points are checked so that a corrupt index can't cause out of bounds
+ * accesses in lowzip_read_range().
+ */
+void lowzip_load_index(lowzip_state *st, lowzip_index *idx, const unsigned char *data, unsigned int length) {
+	lowzip_file *fi;
+	const lowzip_index_point *pt;
+	unsigned int hdr[LOWZIP_INDEX_HEADER_SIZE / 4];
+	unsigned int prev;
+	unsigned int prev_in;
+	unsigned int i;
+
+	fi = (lowzip_file *) st->scratch;
+	st->have_error = 0;
+	memset((void *) idx, 0, sizeof(*idx));
+
+	if (length < LOWZIP_INDEX_HEADER_SIZE || ((size_t) data & 0x03U) != 0) {
+		goto fail;
+	}
+	memcpy((void *) hdr, (const void *) data, LOWZIP_INDEX_HEADER_SIZE);
+	if (hdr[0] != LOWZIP_INDEX_MAGIC || hdr[1] != LOWZIP_INDEX_VERSION ||
+	    hdr[11] != (unsigned int) sizeof(lowzip_index_point)) {
+		goto fail;
+	}
+	if (hdr[2] != fi->compression_method || hdr[3] != fi->crc32 ||
+	    hdr[4] != fi->compressed_size || hdr[5] != fi->uncompressed_size ||
+	    hdr[6] != fi->local_header_offset || hdr[7] != fi->data_offset) {
+		goto fail;  /* Stale or for another file. */
+	}
+	if (hdr[9] > (length - LOWZIP_INDEX_HEADER_SIZE) / sizeof(lowzip_index_point) ||
+	    hdr[10] > length - LOWZIP_INDEX_HEADER_SIZE - hdr[9] * (unsigned int) sizeof(lowzip_index_point)) {
+		goto fail;
+	}
+
+	idx->compression_method = hdr[2];
+	idx->crc32 = hdr[3];
+	idx->compressed_size = hdr[4];
+	idx->uncompressed_size = hdr[5];
+	idx->local_header_offset = hdr[6];
+	idx->data_offset = hdr[7];
+	idx->spacing = hdr[8];
+	idx->num_points = hdr[9];
+	idx->max_points = hdr[9];
+	idx->windows_used = hdr[10];
+	idx->windows_size = hdr[10];
+	idx->points = (lowzip_index_point *) (data + LOWZIP_INDEX_HEADER_SIZE);
+	idx->windows = (unsigned char *) (data + LOWZIP_INDEX_HEADER_SIZE + idx->num_points * sizeof(lowzip_index_point));
+
+	prev = 0;
+	prev_in = 0;
+	for (i = 0; i < idx->num_points; i++) {
+		pt = idx->points + i;
+		if (pt->out_offset <= prev || pt->out_offset > idx->uncompressed_size ||
+		    pt->in_offset < prev_in || pt->in_offset > idx->compressed_size ||
+		    pt->window_length > 32768U || pt->window_length > pt->out_offset ||
+		    pt->window_offset > idx->windows_used ||
+		    pt->window_length > idx->windows_used - pt->window_offset ||
+		    pt->bits > 7) {
+			goto fail;
+		}
+		prev = pt->out_offset;
+		prev_in = pt->in_offset;
+	}
+	return;
+
+ fail:
+	memset((void *) idx, 0, sizeof(*idx));
+	st->have_error = 1;
+}
+#endif  /* LOWZIP_RANDOM_ACCESS */
+
+/*
+ *  gzip and BGZF
+ */
+
+#if defined(LOWZIP_GZIP)
+
+/* Skip a zero terminated header field, returns the offset following it.
+ * A read error returns zero like the terminator and sets st->have_error.
+ */
+static unsigned int lowzip_gzip_skip_string(lowzip_state *st, unsigned int offset) {
+	while (lowzip_read1(st, offset++) != 0) {
+		;
+	}
+	return offset;
+}
+
+/* Parse the gzip member header at 'offset', see lowzip.h.  The optional
+ * header fields are skipped; FHCRC isn't checked.
+ */
+void lowzip_gzip_header(lowzip_state *st, unsigned int offset, lowzip_gzip_member *m) {
+	unsigned int flags;
+	unsigned int p;
+	unsigned int xend;
+	unsigned int slen;
+
+	st->have_error = 0;
+	memset((void *) m, 0, sizeof(*m));
+	m->offset = offset;
+
+	if (offset >= st->zip_length || lowzip_read2(st, offset) != 0x8b1fU || lowzip_read1(st, offset + 2) != 8) {
+		goto fail;
+	}
+	flags = lowzip_read1(st, offset + 3);
+	if (flags & LOWZIP_GZIP_FRESERVED) {
+		goto fail;
+	}
+	m->flags = flags;
+	m->mtime = lowzip_read4(st, offset + 4);
+	p = offset + LOWZIP_GZIP_HEADER_LENGTH;
+
+	if (flags & LOWZIP_GZIP_FEXTRA) {
+		/* Subfields are SI1, SI2, LEN (2 bytes) and LEN bytes of
+		 * data.  BGZF has a 'BC' subfield with the member size
+		 * minus one (BSIZE).
+		 */
+		xend = p + 2 + lowzip_read2(st, p);
+		p += 2;
+		while (p < xend && xend - p >= 4 && !st->have_error) {
+			slen = lowzip_read2(st, p + 2);
+			if (lowzip_read2(st, p) == LOWZIP_BGZF_SUBFIELD && slen == 2) {
+				m->block_size = lowzip_read2(st, p + 4) + 1U;
+			}
+			p += 4 + slen;
+		}
+		if (p != xend) {
+			goto fail;
+		}
+	}
+	if (flags & LOWZIP_GZIP_FNAME) {
+		p = lowzip_gzip_skip_string(st, p);
+	}
+	if (flags & LOWZIP_GZIP_FCOMMENT) {
+		p = lowzip_gzip_skip_string(st, p);
+	}
+	if (flags & LOWZIP_GZIP_FHCRC) {
+		p += 2;
+	}
+	if (st->have_error || p >= st->zip_length) {
+		goto fail;
+	}
+	m->data_offset = p;
+
+	if (m->block_size > 0) {
+		/* BGZF: the trailer is at the end of the member, so its
+		 * size and CRC-32 are known without decoding.
+		 */
+		if (m->block_size < p - offset + LOWZIP_GZIP_TRAILER_LENGTH ||
+		    m->block_size > st->zip_length - offset) {
+			goto fail;
+		}
+		m->end_offset = offset + m->block_size;
+		m->crc32 = lowzip_read4(st, m->end_offset - 8);
+		m->uncompressed_size = lowzip_read4(st, m->end_offset - 4);
+		if (st->have_error) {
+			goto fail;
+		}
+	}
+	return;
+
+ fail:
+	st->have_error = 1;
+}
+
+/* Inflate the data of a gzip member parsed using lowzip_gzip_header().
+ * Output is like for lowzip_get_data(), including streaming, and is
+ * checked against the trailer which follows the final block.
+ */
+void lowzip_gzip_get_data(lowzip_state *st, lowzip_gzip_member *m) {
+	unsigned int offset;
+
+	st->have_error = 0;
+	st->crc32 = 0xffffffffUL;
+	st->crc_next = st->output_next;
+	lowzip_init_output(st);
+
+	st->read_offset = m->data_offset;
+	st->mode = LOWZIP_MODE_HEADER;
+	lowzip_reset_bitstate(st);
+	lowzip_inflate_run(st);
+	if (st->have_error) {
+		goto fail;
+	}
+#if defined(LOWZIP_STREAMING)
+	if (st->write_callback) {
+		lowzip_flush_output(st);
+		if (st->have_error) {
+			goto fail;
+		}
+	}
+#endif
+
+	/* The trailer starts at the byte following the final block, whole
+	 * bytes in the bit buffer are re-read.
+	 */
+	offset = st->read_offset - (st->have >> 3U);
+	if (m->block_size > 0 && offset + LOWZIP_GZIP_TRAILER_LENGTH != m->end_offset) {
+		goto fail;
+	}
+	m->crc32 = lowzip_read4(st, offset);
+	m->uncompressed_size = lowzip_read4(st, offset + 4);
+	m->end_offset = offset + LOWZIP_GZIP_TRAILER_LENGTH;
+	if (st->have_error) {
+		goto fail;
+	}
+
+	/* ISIZE is the length modulo 2^32. */
+	if (lowzip_output_length(st) != m->uncompressed_size) {
+		goto fail;
+	}
+	lowzip_update_output_crc(st);
+	if ((st->crc32 ^ 0xffffffffUL) != m->crc32) {
+		goto fail;
+	}
+
+	st->crc_next = NULL;
+	return;
+
+ fail:
+	st->crc_next = NULL;
+	st->have_error = 1;
+}
+
+/* Build a BGZF block index by walking the member headers, see lowzip.h.
+ * No data is decoded: sizes come from BSIZE and the trailers.
+ */
+void lowzip_build_bgzf_index(lowzip_state *st, lowzip_bgzf_index *idx) {
+	lowzip_gzip_member m;
+	unsigned int offset;
+	unsigned int uoffset;
+
+	idx->num_blocks = 0;
+	idx->compressed_size = 0;
+	idx->uncompressed_size = 0;
+
+	offset = 0;
+	uoffset = 0;
+	while (offset < st->zip_length) {
+		lowzip_gzip_header(st, offset, &m);
+		if (st->have_error || m.block_size == 0 || m.uncompressed_size > LOWZIP_BGZF_MAX_BLOCK ||
+		    m.uncompressed_size > 0xffffffffUL - uoffset || idx->num_blocks >= idx->max_blocks) {
+			goto fail;
+		}
+		idx->blocks[idx->num_blocks].coffset = offset;
+		idx->blocks[idx->num_blocks].uoffset = uoffset;
+		idx->num_blocks++;
+		offset = m.end_offset;
+		uoffset += m.uncompressed_size;
+	}
+	idx->compressed_size = offset;
+	idx->uncompressed_size = uoffset;
+	st->have_error = 0;
 	return;
 
+ fail:
+	idx->num_blocks = 0;
+	st->have_error = 1;
+}
+
+/* Uncompressed size of block 'i'. */
+static unsigned int lowzip_bgzf_block_size(const lowzip_bgzf_index *idx, unsigned int i) {
+	return (i + 1 < idx->num_blocks ? idx->blocks[i + 1].uoffset : idx->uncompressed_size) - idx->blocks[i].uoffset;
+}
+
+unsigned long long lowzip_bgzf_voffset(const lowzip_bgzf_index *idx, unsigned int offset) {
+	unsigned int lo;
+	unsigned int hi;
+	unsigned int mid;
+
+	/* Last block with uoffset <= offset. */
+	lo = 0;
+	hi = idx->num_blocks;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2U;
+		if (idx->blocks[mid].uoffset <= offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == 0) {
+		return 0;
+	}
+	return ((unsigned long long) idx->blocks[lo - 1].coffset << 16U) | (offset - idx->blocks[lo - 1].uoffset);
+}
+
+/* Read 'length' bytes starting at virtual offset 'voffset' into 'buf'.
+ * Each block involved is decoded (and checked) whole into the output
+ * buffer, which must hold LOWZIP_BGZF_MAX_BLOCK bytes.
+ */
+void lowzip_bgzf_read(lowzip_state *st, const lowzip_bgzf_index *idx, unsigned long long voffset,
+                      unsigned char *buf, unsigned int length) {
+	lowzip_gzip_member m;
+#if defined(LOWZIP_STREAMING)
+	lowzip_write_callback write_callback;
+#endif
+	unsigned int coffset;
+	unsigned int skip;
+	unsigned int lo;
+	unsigned int hi;
+	unsigned int mid;
+	unsigned int t;
+
+	st->have_error = 0;
+	if ((voffset >> 16U) > 0xffffffffUL) {
+		goto fail;
+	}
+	coffset = (unsigned int) (voffset >> 16U);
+	skip = (unsigned int) (voffset & 0xffffU);
+
+	/* Block starting at 'coffset'. */
+	lo = 0;
+	hi = idx->num_blocks;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2U;
+		if (idx->blocks[mid].coffset < coffset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo >= idx->num_blocks || idx->blocks[lo].coffset != coffset ||
+	    skip > lowzip_bgzf_block_size(idx, lo) ||
+	    length > idx->uncompressed_size - idx->blocks[lo].uoffset - skip) {
+		goto fail;
+	}
+
+#if defined(LOWZIP_STREAMING)
+	write_callback = st->write_callback;
+	st->write_callback = NULL;
+#endif
+	for (; length > 0; lo++) {
+		lowzip_gzip_header(st, idx->blocks[lo].coffset, &m);
+		if (st->have_error) {
+			break;
+		}
+		st->output_next = st->output_start;
+		lowzip_gzip_get_data(st, &m);
+		t = (unsigned int) (st->output_next - st->output_start);
+		if (st->have_error || t != lowzip_bgzf_block_size(idx, lo)) {
+			break;  /* Index doesn't match the data. */
+		}
+		t -= skip;
+		if (t > length) {
+			t = length;
+		}
+		memcpy((void *) buf, (const void *) (st->output_start + skip), t);
+		buf += t;
+		length -= t;
+		skip = 0;
+	}
+#if defined(LOWZIP_STREAMING)
+	st->write_callback = write_callback;
+#endif
+	if (length == 0) {
+		st->have_error = 0;
+		return;
+	}
+
  fail:
 	st->have_error = 1;
 }
+#endif  /* LOWZIP_GZIP */
@@ -1,12 +1,280 @@
 #if !defined(LOWZIP_H_INCLUDED)
 #define LOWZIP_H_INCLUDED
 
-/* Read callback, limited to single byte reads at present for simplicity.
- * Return value is a byte in range [0x00,0xff] or 0x100 if out of bounds
- * or any other error.
+/* Optional features.  These must be defined identically when compiling
+ * lowzip.c and any code including lowzip.h because some of them change
+ * the size of lowzip_state.  Defining LOWZIP_FAST enables all of them;
+ * the defaults favor footprint over speed.
+ *
+ *   LOWZIP_FAST_HUFFMAN: table-driven Huffman decoding, a whole symbol
+ *   per lookup instead of one bit at a time.  Increases lowzip_state
+ *   by about 2.9kB.
+ *
+ *   LOWZIP_FAST_BITREADER: 64-bit bit buffer kept in local variables
+ *   while decoding Huffman block data, refilled with 8-byte loads from
+ *   the input window.  Requires 'unsigned long long'.
+ *
+ *   LOWZIP_FAST_STATIC_HUFFMAN: precomputed lookup tables for static
+ *   Huffman blocks, about 1.1kB of const data.
+ *
+ *   LOWZIP_FAST_COPY: back-references are copied in 8/16/32-byte chunks
+ *   instead of one byte at a time, short repeating patterns are widened
+ *   to 8 bytes first.
+ *
+ *   LOWZIP_FAST_CRC32: slicing-by-8 table-driven CRC-32 for checking
+ *   extracted data, 8kB of const tables.  The default is a bitwise CRC.
+ *   On x86-64 GCC/Clang builds a PCLMULQDQ kernel is also included and
+ *   selected at runtime (LOWZIP_NO_CLMUL disables it).
+ *
+ * Optional APIs, not enabled by LOWZIP_FAST:
+ *
+ *   LOWZIP_STREAMING: streamed output through st->write_callback with a
+ *   sliding output window, for files larger than the output buffer.
+ *   Needed by lowzip_extract.c and implied by LOWZIP_RANDOM_ACCESS.
+ *   About 0.5kB of code and 16 bytes of lowzip_state.
+ *
+ *   LOWZIP_SHARED_ARCHIVE: sharing an opened archive between threads
+ *   (lowzip_export_archive(), lowzip_attach_archive()), needed by
+ *   lowzip_extract.c.  About 0.2kB of code.
+ *
+ *   LOWZIP_ITERATOR: one pass central directory iteration
+ *   (lowzip_iter_begin() etc), needed by lowzip_extract.c.  About 0.6kB
+ *   of code.
+ *
+ *   LOWZIP_NAME_INDEX: in-RAM filename hash index for lowzip_locate_file()
+ *   (lowzip_build_name_index()) and batch filename lookups
+ *   (lowzip_locate_files(), lowzip_locate_entry()).  About 1.5kB of code
+ *   and 16 bytes of lowzip_state.
+ *
+ *   LOWZIP_OFFSET_TABLE: central directory offset table for
+ *   lowzip_locate_file() by index (lowzip_build_offset_table()).  About
+ *   0.5kB of code and 16 bytes of lowzip_state.
+ *
+ *   LOWZIP_RESUMABLE: resumable raw inflate for input arriving over time
+ *   (lowzip_inflate_init(), lowzip_inflate_resume(), lowzip_inflate_push()).
+ *   About 1kB of code and 48 bytes of lowzip_state.
+ *
+ *   LOWZIP_RANDOM_ACCESS: checkpoint indexes and range reads of large
+ *   Deflate entries (lowzip_build_index(), lowzip_read_range()) and the
+ *   saved index format (lowzip_save_index(), lowzip_load_index()).  About
+ *   1.8kB of code and 32 bytes of lowzip_state on top of LOWZIP_STREAMING.
+ *
+ *   LOWZIP_SPECULATIVE: speculative chunk decoding of a raw Deflate
+ *   stream (lowzip_find_chunk() etc), needed by lowzip_parallel.c.
+ *   About 2.2kB of code.
+ *
+ *   LOWZIP_GZIP: gzip files, including multi-member files, and BGZF
+ *   block indexes and virtual offsets (lowzip_gzip_header() etc), needed
+ *   by lowzip_parallel.c.  About 1.6kB of code; BGZF virtual offsets
+ *   require 'unsigned long long'.
+ */
+#if defined(LOWZIP_RANDOM_ACCESS)
+#if !defined(LOWZIP_STREAMING)
+#define LOWZIP_STREAMING
+#endif
+#endif
+#if defined(LOWZIP_FAST)
+#if !defined(LOWZIP_FAST_HUFFMAN)
+#define LOWZIP_FAST_HUFFMAN
+#endif
+#if !defined(LOWZIP_FAST_BITREADER)
+#define LOWZIP_FAST_BITREADER
+#endif
+#if !defined(LOWZIP_FAST_STATIC_HUFFMAN)
+#define LOWZIP_FAST_STATIC_HUFFMAN
+#endif
+#if !defined(LOWZIP_FAST_COPY)
+#define LOWZIP_FAST_COPY
+#endif
+#if !defined(LOWZIP_FAST_CRC32)
+#define LOWZIP_FAST_CRC32
+#endif
+#endif
+
+/* Bit buffer for inflate bitstream decoding. */
+#if defined(LOWZIP_FAST_BITREADER)
+typedef unsigned long long lowzip_bitbuf;
+#else
+typedef unsigned int lowzip_bitbuf;
+#endif
+
+/* Size of the input buffer used with a span read callback and for bytes
+ * carried over by push input (LOWZIP_RESUMABLE).  The buffer is part of every lowzip_state
+ * (64 bytes by default) even when neither is used; such builds can lower
+ * it to 16, the minimum.  Larger values mean fewer span reads.
+ */
+#if !defined(LOWZIP_INPUT_BUFFER_SIZE)
+#define LOWZIP_INPUT_BUFFER_SIZE  64
+#endif
+
+/* Read callback, single byte reads for simplicity.  Return value is a byte
+ * in range [0x00,0xff] or 0x100 if out of bounds or any other error.
  */
 typedef unsigned int (*lowzip_read_callback)(void *udata, unsigned int offset);
 
+/* Span read callback, reads up to 'length' bytes starting at 'offset' into
+ * 'buf'.  Return value is the number of bytes delivered, which may be less
+ * than 'length' (zero if out of bounds or any other error).
+ */
+typedef unsigned int (*lowzip_read_span_callback)(void *udata, unsigned int offset, unsigned char *buf, unsigned int length);
+
+#if defined(LOWZIP_STREAMING)
+/* Output callback for streaming output, called with output bytes which are
+ * complete.  Return zero on success, non-zero to abort with an error.
+ */
+typedef int (*lowzip_write_callback)(void *udata, const unsigned char *buf, unsigned int length);
+
+/* Minimum output buffer size for streaming output: a 32kB inflate window
+ * plus room for a maximum length back-reference.  A larger buffer means
+ * fewer callbacks and less copying; 64kB or more is a reasonable size.
+ */
+#define LOWZIP_STREAM_OUTPUT_MIN  (32768U + 258U)
+#endif
+
+#if defined(LOWZIP_RANDOM_ACCESS)
+/* Random access checkpoint in a Deflate entry, see lowzip_build_index().
+ * Checkpoints are at block boundaries: decoding restarts at compressed
+ * byte 'in_offset' (relative to the entry data) with 'bits' (0-7) unread
+ * bits of the preceding byte in 'bit_value', and the 'window_length'
+ * bytes of output preceding 'out_offset' as the inflate window.
+ */
+typedef struct {
+	unsigned int out_offset;
+	unsigned int in_offset;
+	unsigned int window_offset;  /* Offset of window in index 'windows'. */
+	unsigned short window_length;
+	unsigned char bits;
+	unsigned char bit_value;
+} lowzip_index_point;
+
+/* Checkpoint index for one Deflate entry.  Caller provides 'points'
+ * ('max_points' entries), 'windows' storage ('windows_size' bytes, up to
+ * 32kB per checkpoint) and 'spacing', the minimum uncompressed distance
+ * between checkpoints.  The rest is filled in by lowzip_build_index():
+ * the entry's CRC-32, sizes and data offset identify the entry.  When
+ * 'points' or 'windows' run out, later checkpoints are left out.
+ */
+typedef struct {
+	lowzip_index_point *points;
+	unsigned int max_points;
+	unsigned int num_points;
+	unsigned char *windows;
+	unsigned int windows_size;
+	unsigned int windows_used;
+	unsigned int spacing;
+
+	unsigned int compression_method;
+	unsigned int crc32;
+	unsigned int compressed_size;
+	unsigned int uncompressed_size;
+	unsigned int local_header_offset;
+	unsigned int data_offset;
+} lowzip_index;
+
+/* Saved index format, see lowzip_save_index().  A 48-byte header of
+ * 32-bit fields (magic, version, compression method, CRC-32, compressed
+ * and uncompressed size, local header offset, data offset, spacing,
+ * number of points, windows length, point size) followed by the points
+ * and the windows.  Fields are in native byte order so that the points
+ * can be used in place; the magic doesn't match on a host with different
+ * byte order and such an index is rejected.
+ */
+#define LOWZIP_INDEX_MAGIC        0x58495a4cUL  /* "LZIX" on little endian hosts. */
+#define LOWZIP_INDEX_VERSION      1
+#define LOWZIP_INDEX_HEADER_SIZE  48
+#endif  /* LOWZIP_RANDOM_ACCESS */
+
+#if defined(LOWZIP_SPECULATIVE)
+/* Position in compressed input, like for checkpoints: byte 'offset' with
+ * 'bits' (0-7) unread bits of the preceding byte.
+ */
+typedef struct {
+	unsigned int offset;
+	unsigned int bits;
+} lowzip_bitpos;
+
+/* Speculatively decoded part of a raw Deflate stream, see
+ * lowzip_find_chunk().  Output is a sequence of 16-bit symbols: literal
+ * bytes (0-255), or LOWZIP_SYMBOL_WINDOW + i for byte i of the (unknown)
+ * 32kB window preceding the chunk, 32767 being the byte right before it.
+ * Caller provides 'symbols' ('symbols_size' entries) and optionally sorted
+ * 'stops' ('num_stops' entries), block positions where decoding stops such
+ * as the starts of later chunks.  The rest is managed internally: 'start'
+ * and 'end' are the block positions where decoding started and stopped,
+ * 'stop_index' the stop reached (-1 for the end of the final block), and
+ * 'window_length' the length of the window (zero at the stream start).
+ */
+#define LOWZIP_SYMBOL_WINDOW  0x100U
+
+typedef struct {
+	unsigned short *symbols;
+	unsigned int symbols_size;
+	const lowzip_bitpos *stops;
+	unsigned int num_stops;
+
+	lowzip_bitpos start;
+	lowzip_bitpos end;
+	unsigned int symbols_length;
+	unsigned int window_length;
+	unsigned int next_stop;
+	int stop_index;
+} lowzip_chunk;
+#endif  /* LOWZIP_SPECULATIVE */
+
+#if defined(LOWZIP_GZIP)
+/* gzip member (RFC 1952), see lowzip_gzip_header(): offsets of the member
+ * and its Deflate data, header FLG and MTIME fields, and the trailer
+ * CRC-32 and ISIZE (uncompressed size modulo 2^32).  'block_size' is the
+ * whole member size for a BGZF block (non-zero only if the header has a
+ * BGZF 'BC' subfield).  The trailer fields and 'end_offset', the offset
+ * following the member, are known from the header for BGZF blocks and
+ * otherwise filled in by lowzip_gzip_get_data().
+ */
+typedef struct {
+	unsigned int offset;
+	unsigned int data_offset;
+	unsigned int flags;
+	unsigned int mtime;
+	unsigned int block_size;
+	unsigned int crc32;
+	unsigned int uncompressed_size;
+	unsigned int end_offset;
+} lowzip_gzip_member;
+
+/* BGZF block index, see lowzip_build_bgzf_index().  Caller provides
+ * 'blocks' ('max_blocks' entries; blocks are at least 28 bytes so the
+ * input length / 28 + 1 is enough for a valid file).  Each block has its compressed
+ * offset and the uncompressed offset of its data.  A virtual offset is
+ * (compressed block offset << 16) | offset within the block, as used by
+ * BAM and tabix indexes.  BGZF blocks hold at most LOWZIP_BGZF_MAX_BLOCK
+ * bytes of data.
+ */
+#define LOWZIP_BGZF_MAX_BLOCK  65536U
+
+typedef struct {
+	unsigned int coffset;
+	unsigned int uoffset;
+} lowzip_bgzf_block;
+
+typedef struct {
+	lowzip_bgzf_block *blocks;
+	unsigned int max_blocks;
+	unsigned int num_blocks;
+	unsigned int compressed_size;
+	unsigned int uncompressed_size;
+} lowzip_bgzf_index;
+#endif  /* LOWZIP_GZIP */
+
+#if defined(LOWZIP_NAME_INDEX)
+/* Filename hash index entry, see lowzip_build_name_index(): filename hash
+ * and central directory entry offset (zero for an empty slot).
+ */
+typedef struct {
+	unsigned int hash;
+	unsigned int offset;
+} lowzip_name_entry;
+#endif
+
 /* Lowzip state structure, allocated and initialized (partially) by caller.
  * Also contains the inflate state.
  */
@@ -17,6 +285,11 @@ typedef struct {
 	/* User-provided read callback to access the ZIP file. */
 	lowzip_read_callback read_callback;
 
+	/* Optional user-provided span read callback.  If set, it's used
+	 * instead of read_callback (which may then be NULL).
+	 */
+	lowzip_read_span_callback read_span_callback;
+
 	/* ZIP file length. */
 	unsigned int zip_length;
 
@@ -25,19 +298,120 @@ typedef struct {
 	unsigned char *output_end;
 	unsigned char *output_next;  /* Initialize to 'output_start'. */
 
+#if defined(LOWZIP_STREAMING)
+	/* Optional user-provided output callback.  If set, output is
+	 * streamed: [output_start,output_end[ is used as a sliding window
+	 * (at least LOWZIP_STREAM_OUTPUT_MIN bytes) and when it fills up,
+	 * completed output is passed to the callback and the last 32kB are
+	 * moved to the start of the buffer.  'output_flushed' counts output
+	 * passed so far; managed internally.
+	 */
+	lowzip_write_callback write_callback;
+	unsigned int output_flushed;
+#endif
+
+	/* Start of output not yet passed to the write callback (or of all
+	 * output of the current call), managed internally.
+	 */
+	unsigned char *flush_next;
+
+	/* Block level decoder state, managed internally: 'mode' is the
+	 * position in the block level state machine, 'block_final' the
+	 * BFINAL bit of the current block, 'block_remain' the stored block
+	 * bytes left or the number of code lengths decoded, and
+	 * 'nlit'/'ndist' the dynamic Huffman table sizes.
+	 */
+	unsigned int mode;
+	unsigned int block_final;
+	unsigned int block_remain;
+	unsigned int nlit;
+	unsigned int ndist;
+
+#if defined(LOWZIP_RESUMABLE)
+	/* Resumable inflate, see lowzip_inflate_resume().  'input_more' is
+	 * set by the caller when more input may follow the input window.
+	 * The checkpoint (cp_*) is the input and output position where
+	 * decoding resumes if input runs out.
+	 */
+	int input_more;
+	int need_input;
+	unsigned int cp_read_offset;
+	lowzip_bitbuf cp_curr;
+	unsigned int cp_have;
+	unsigned char *cp_output_next;
+
+	/* Push input, see lowzip_inflate_push(): the caller sets 'next_in'
+	 * and 'avail_in', which are advanced over consumed input.  An
+	 * incomplete symbol at the end of the input is carried over in
+	 * 'input_buf' ('input_carry' bytes), so the caller's buffer can be
+	 * reused after the call.
+	 */
+	const unsigned char *next_in;
+	unsigned int avail_in;
+	unsigned int input_carry;
+#endif
+
+#if defined(LOWZIP_RANDOM_ACCESS)
+	/* Random access, managed internally: 'index' is the index being
+	 * built by lowzip_build_index(), and output bytes after the first
+	 * 'range_skip' are copied to 'range_next' until 'range_left' runs
+	 * out in lowzip_read_range().
+	 */
+	lowzip_index *index;
+	unsigned char *range_next;
+	unsigned int range_skip;
+	unsigned int range_left;
+#endif
+
+	/* Running CRC-32 (pre-inverted) of output [output_start,crc_next[,
+	 * computed during lowzip_get_data().  Managed internally.
+	 */
+	unsigned int crc32;
+	unsigned char *crc_next;
+
 	/* Offset to start of central header. */
 	unsigned int central_dir_offset;
 
+#if defined(LOWZIP_NAME_INDEX)
+	/* Optional filename hash index ('name_index_size' slots), set up by
+	 * lowzip_build_name_index().
+	 */
+	const lowzip_name_entry *name_index;
+	unsigned int name_index_size;
+#endif
+
+#if defined(LOWZIP_OFFSET_TABLE)
+	/* Optional central directory offset table, set up by
+	 * lowzip_build_offset_table(): offsets of the first
+	 * 'entry_offsets_count' entries, 'entry_offsets_complete' if that's
+	 * all of them.
+	 */
+	const unsigned int *entry_offsets;
+	unsigned int entry_offsets_count;
+	int entry_offsets_complete;
+#endif
+
 	/* Error flag, for delayed error detection. */
 	int have_error;
 
 	/* Read offset (used by inflate code). */
 	unsigned int read_offset;
 
-	/* State for bitstream decoding (used by inflate code). */
-	unsigned int curr;
+	/* State for bitstream decoding (used by inflate code).  'have' bits
+	 * are available in the low bits of 'curr'.
+	 */
+	lowzip_bitbuf curr;
 	unsigned int have;
 
+	/* Input window: ZIP file bytes [input_offset,input_offset+input_length[
+	 * are available at input_data.  For an in-memory archive the window
+	 * covers the whole archive, for span reads it points to input_buf.
+	 */
+	const unsigned char *input_data;
+	unsigned int input_offset;
+	unsigned int input_length;
+	unsigned char input_buf[LOWZIP_INPUT_BUFFER_SIZE];
+
 	/* Temporary scratch area used by both ZIP parsing and inflate.
 	 * Huffman decoding needs the largest state; for size calculation
 	 * see comments in prepare_huffman().  Declared as an array of
@@ -48,10 +422,45 @@ typedef struct {
 	 *   32 + 64 bytes  = 96 bytes for distance Huffman table
 	 *   288 + 32 bytes = 320 bytes for nlit+ndist temporary code lengths
 	 *   = 1020 bytes --> 510 16-bit ints.
+	 *
+	 * With LOWZIP_FAST_HUFFMAN each Huffman table is followed by a
+	 * lookup table:
+	 *   32 + 576 + 2 + 1704 bytes = 2314 bytes for literal/length
+	 *   32 + 64 + 2 + 1184 bytes  = 1282 bytes for distance
+	 *   288 + 32 bytes            = 320 bytes for temporary code lengths
+	 *   = 3916 bytes --> 1958 16-bit ints.
 	 */
+#if defined(LOWZIP_FAST_HUFFMAN)
+	unsigned short scratch[1958];
+#else
 	unsigned short scratch[510];
+#endif
 } lowzip_state;
 
+#if defined(LOWZIP_SHARED_ARCHIVE)
+/* Shared archive handle: the archive level part of a lowzip_state after
+ * opening, see lowzip_export_archive().  Not modified after export, so
+ * any number of threads can attach their own lowzip_state to it.
+ */
+typedef struct {
+	void *udata;
+	lowzip_read_callback read_callback;
+	lowzip_read_span_callback read_span_callback;
+	unsigned int zip_length;
+	const unsigned char *data;  /* In-memory archive, NULL for callbacks. */
+	unsigned int central_dir_offset;
+#if defined(LOWZIP_NAME_INDEX)
+	const lowzip_name_entry *name_index;
+	unsigned int name_index_size;
+#endif
+#if defined(LOWZIP_OFFSET_TABLE)
+	const unsigned int *entry_offsets;
+	unsigned int entry_offsets_count;
+	int entry_offsets_complete;
+#endif
+} lowzip_archive;
+#endif  /* LOWZIP_SHARED_ARCHIVE */
+
 /* Metadata about the most recent file header looked up from the ZIP file. */
 typedef struct {
 	/* Compression method: 0=Store, 8=Deflate. */
@@ -69,18 +478,232 @@ typedef struct {
 	/* Offset to start of compressed data. */
 	unsigned int data_offset;
 
+	/* Offset to local file header. */
+	unsigned int local_header_offset;
+
+	/* Filename length in the central directory; larger than 255 if
+	 * 'filename' was truncated.
+	 */
+	unsigned int filename_length;
+
 	/* Filename, truncated to 255 characters.  ZIP filenames can be
 	 * 65535 bytes long, but 255 is enough in practice.
 	 */
 	char filename[255+1];
 } lowzip_file;
 
+#if defined(LOWZIP_ITERATOR)
+/* Central directory iterator cursor, see lowzip_iter_begin(). */
+typedef struct {
+	unsigned int entry_offset;  /* Entry most recently returned. */
+	unsigned int next_offset;
+	unsigned int index;         /* Index of next entry. */
+} lowzip_iter;
+#endif
+
+#if defined(LOWZIP_NAME_INDEX)
+/* Central directory entry found by lowzip_locate_files(): entry offset
+ * (zero if not found) and file info from the central directory record.
+ */
+typedef struct {
+	unsigned int offset;
+	unsigned int compression_method;
+	unsigned int crc32;
+	unsigned int compressed_size;
+	unsigned int uncompressed_size;
+	unsigned int local_header_offset;
+} lowzip_entry;
+#endif
+
 /* ZIP API */
 extern void lowzip_init_archive(lowzip_state *st);
+extern void lowzip_init_archive_mem(lowzip_state *st, const unsigned char *data, unsigned int length);
 extern lowzip_file *lowzip_locate_file(lowzip_state *st, int idx, const char *name);
+
+#if defined(LOWZIP_SHARED_ARCHIVE)
+/* Sharing an archive between threads: open it once with a lowzip_state
+ * (and optionally build the name index and offset table), then
+ * lowzip_export_archive() copies the archive level information into 'ar'.
+ * Each thread then owns a lowzip_state initialized with
+ * lowzip_attach_archive(), which doesn't read the archive, and uses it
+ * for locating, iterating and decoding as usual.
+ *
+ * Thread-safety rules: 'ar', the in-memory archive data and the index
+ * tables must not be modified while attached states are in use.  A state
+ * is used by one thread at a time.  Read callbacks are called concurrently
+ * from all threads with 'udata' from the archive, so they must be thread
+ * safe (e.g. use pread() instead of a shared file position), or each
+ * thread sets its own st->udata after attaching.
+ */
+extern void lowzip_export_archive(const lowzip_state *st, lowzip_archive *ar);
+extern void lowzip_attach_archive(lowzip_state *st, const lowzip_archive *ar);
+#endif
+
+#if defined(LOWZIP_ITERATOR)
+/* Enumerate files in one linear central directory pass.  lowzip_iter_next()
+ * returns file info taken from the central directory record alone, so
+ * 'data_offset' isn't known and is zero; NULL is returned after the last
+ * file (st->have_error is set only if the directory is corrupt).  Like
+ * lowzip_locate_file() the struct is in the shared scratch area.  To read
+ * the data, lowzip_iter_locate() makes the entry most recently returned
+ * the current file, reading its local file header.
+ */
+extern void lowzip_iter_begin(lowzip_state *st, lowzip_iter *it);
+extern lowzip_file *lowzip_iter_next(lowzip_state *st, lowzip_iter *it);
+extern lowzip_file *lowzip_iter_locate(lowzip_state *st, const lowzip_iter *it);
+#endif
+
+#if defined(LOWZIP_NAME_INDEX)
+/* Optional in-RAM filename index so that lowzip_locate_file() by name is a
+ * hash probe and one filename check instead of a central directory scan.
+ * Built in one central directory pass into caller provided 'table' of
+ * 'size' slots (8 bytes each), which must be larger than the number of
+ * files; about twice the number of files keeps probe sequences short.
+ * The table must remain valid while the state is used.  On error (table
+ * too small) st->have_error is set and lookups scan as before.
+ * lowzip_init_archive() drops the index; rebuild it after reopening.
+ */
+extern void lowzip_build_name_index(lowzip_state *st, lowzip_name_entry *table, unsigned int size);
+
+/* Batch lookup of many names without a persistent index: the 'count'
+ * names are hashed into caller provided 'table' of 'size' slots, which
+ * must be larger than 'count' (about twice keeps probe sequences short),
+ * and then one central directory pass fills 'entries[i]' for each name
+ * found.  Returns the number of names found; entries of names not found
+ * have a zero 'offset'.  An empty batch (zero 'count') returns zero.  st->have_error is set if the table is too small
+ * or the directory is corrupt.  'table' is only used during the call.
+ * lowzip_locate_entry() then makes a found entry the current file, like
+ * lowzip_locate_file() but without another lookup.
+ */
+extern unsigned int lowzip_locate_files(lowzip_state *st, const char * const *names, unsigned int count,
+                                        lowzip_entry *entries, lowzip_name_entry *table, unsigned int size);
+extern lowzip_file *lowzip_locate_entry(lowzip_state *st, const lowzip_entry *e);
+#endif  /* LOWZIP_NAME_INDEX */
+
+#if defined(LOWZIP_OFFSET_TABLE)
+/* Optional central directory offset table so that lowzip_locate_file() by
+ * index jumps straight to the entry instead of scanning from the start.
+ * Filled in one central directory pass into caller provided 'table' of
+ * 'size' entries (4 bytes each), which must remain valid while the state
+ * is used.  If there are more files than 'size', lookups past the table
+ * scan onwards from its last entry.  lowzip_init_archive() drops the
+ * table; rebuild it after reopening.
+ */
+extern void lowzip_build_offset_table(lowzip_state *st, unsigned int *table, unsigned int size);
+#endif
 extern void lowzip_get_data(lowzip_state *st);
 
+#if defined(LOWZIP_RANDOM_ACCESS)
+/* Random access to large entries: lowzip_build_index() decodes the file
+ * most recently located (and checks it like lowzip_get_data()), recording
+ * checkpoints into 'idx'; output is passed to st->write_callback if set,
+ * otherwise discarded.  lowzip_read_range() then reads 'length' bytes at
+ * uncompressed 'offset' of the indexed file into 'buf', decoding only from
+ * the nearest checkpoint; the file doesn't need to be located again.  Both
+ * use [st->output_start,st->output_end[ as a sliding window of at least
+ * LOWZIP_STREAM_OUTPUT_MIN bytes.  Errors set st->have_error.
+ */
+extern void lowzip_build_index(lowzip_state *st, lowzip_index *idx);
+extern void lowzip_read_range(lowzip_state *st, const lowzip_index *idx, unsigned int offset, unsigned char *buf, unsigned int length);
+
+/* Persistent index: lowzip_save_index() writes 'idx' into 'buf' if it has
+ * room, and returns the saved size in either case.  lowzip_load_index()
+ * sets up 'idx' to use saved index 'data' in place (e.g. a memory mapped
+ * file, 4-byte aligned), so 'data' must remain valid and unmodified while
+ * 'idx' is used.  The index must match the file most recently located:
+ * an index for a different or changed file sets st->have_error.
+ */
+extern unsigned int lowzip_save_index(const lowzip_index *idx, unsigned char *buf, unsigned int length);
+extern void lowzip_load_index(lowzip_state *st, lowzip_index *idx, const unsigned char *data, unsigned int length);
+#endif  /* LOWZIP_RANDOM_ACCESS */
+
 /* Raw inflate call; not intended to be used directly. */
 extern void lowzip_inflate_raw(lowzip_state *st);
 
+/* Resumable raw inflate for input arriving over time.  Input is read from
+ * the input window (st->input_data etc, no read callbacks); set
+ * st->input_more while more input may follow.  lowzip_inflate_resume()
+ * returns LOWZIP_INFLATE_NEED_INPUT when the window runs out: the caller
+ * then provides input starting from st->read_offset (earlier input is no
+ * longer needed) and calls lowzip_inflate_resume() again.
+ */
+#define LOWZIP_INFLATE_DONE        0
+#define LOWZIP_INFLATE_NEED_INPUT  1
+#define LOWZIP_INFLATE_ERROR       2
+#if defined(LOWZIP_RESUMABLE)
+extern void lowzip_inflate_init(lowzip_state *st);
+extern int lowzip_inflate_resume(lowzip_state *st);
+
+/* Push-style raw inflate (like zlib inflate()): after lowzip_inflate_init(),
+ * set st->next_in and st->avail_in and call lowzip_inflate_push(), with
+ * 'finish' set for the last input.  Consumed input is the decrease of
+ * st->avail_in, produced output the advance of st->output_next (or the
+ * data passed to st->write_callback).  Returns LOWZIP_INFLATE_NEED_INPUT
+ * when all input has been consumed and more is needed.
+ */
+extern int lowzip_inflate_push(lowzip_state *st, int finish);
+#endif  /* LOWZIP_RESUMABLE */
+
+#if defined(LOWZIP_SPECULATIVE)
+/* Speculative decoding of a raw Deflate stream in chunks, for decoding in
+ * parallel (see lowzip_parallel.h).  Input is read from the input window.
+ * lowzip_start_chunk() starts a chunk at the stream start (st->read_offset).
+ * lowzip_find_chunk() searches input bytes [offset,end[ for the first
+ * position where a non-final dynamic Huffman block header parses, its
+ * Huffman codes are complete like encoders produce, and the block decodes
+ * without errors (into 'symbols', which must have room for the whole
+ * block) followed by a valid block header; it returns zero if there's no
+ * such position.  A match may be a false block start, so output must only
+ * be used once decoding of the preceding chunk stops exactly at 'start'.
+ *
+ * lowzip_inflate_chunk() then decodes until a stop or the end of the final
+ * block (LOWZIP_INFLATE_DONE), an error (LOWZIP_INFLATE_ERROR), or until
+ * 'symbols' is too full for the next symbol: LOWZIP_INFLATE_NEED_OUTPUT,
+ * the caller then provides a larger buffer with the symbols decoded so far
+ * and calls again.
+ *
+ * lowzip_resolve_chunk() converts 'count' symbols starting from symbol
+ * 'first' into bytes in 'out', given the 'window_length' (up to 32kB)
+ * bytes of output preceding the chunk in 'window'.  Returns non-zero if a
+ * symbol refers to before the start of the output.
+ */
+#define LOWZIP_INFLATE_NEED_OUTPUT  3
+extern void lowzip_start_chunk(lowzip_state *st, lowzip_chunk *ch);
+extern int lowzip_find_chunk(lowzip_state *st, lowzip_chunk *ch, unsigned int offset, unsigned int end);
+extern int lowzip_inflate_chunk(lowzip_state *st, lowzip_chunk *ch);
+extern int lowzip_resolve_chunk(const lowzip_chunk *ch, unsigned int first, unsigned int count,
+                                const unsigned char *window, unsigned int window_length, unsigned char *out);
+#endif  /* LOWZIP_SPECULATIVE */
+
+#if defined(LOWZIP_GZIP)
+/* gzip files, including multi-member files and BGZF.  Input is read like
+ * ZIP data (read callbacks or input window) with st->zip_length as the
+ * file length.  lowzip_gzip_header() parses the member header at 'offset'
+ * into 'm'; lowzip_gzip_get_data() then inflates its data into the output
+ * buffer (or streams it, like lowzip_get_data()) and checks it against the
+ * trailer.  The next member, if any, starts at m->end_offset.  Errors set
+ * st->have_error.
+ */
+extern void lowzip_gzip_header(lowzip_state *st, unsigned int offset, lowzip_gzip_member *m);
+extern void lowzip_gzip_get_data(lowzip_state *st, lowzip_gzip_member *m);
+
+/* BGZF random access.  lowzip_build_bgzf_index() walks the block headers
+ * of a BGZF file without decoding anything; st->have_error is set if the
+ * file isn't BGZF (every member must be a BGZF block) or 'blocks' runs
+ * out.  Blocks are independent, so lowzip_gzip_get_data() can decode any
+ * of them, in any order or in parallel (see lowzip_parallel.h).
+ *
+ * lowzip_bgzf_voffset() converts an uncompressed offset (at most the
+ * uncompressed size) to a virtual offset.  lowzip_bgzf_read() reads
+ * 'length' bytes at virtual offset 'voffset' into 'buf', decoding the
+ * blocks involved into [st->output_start,st->output_end[, which must have
+ * room for LOWZIP_BGZF_MAX_BLOCK bytes.  Offsets are 32-bit like the rest
+ * of lowzip, so files are limited to 4GB.
+ */
+extern void lowzip_build_bgzf_index(lowzip_state *st, lowzip_bgzf_index *idx);
+extern unsigned long long lowzip_bgzf_voffset(const lowzip_bgzf_index *idx, unsigned int offset);
+extern void lowzip_bgzf_read(lowzip_state *st, const lowzip_bgzf_index *idx, unsigned long long voffset,
+                             unsigned char *buf, unsigned int length);
+#endif  /* LOWZIP_GZIP */
+
 #endif  /* LOWZIP_H_INCLUDED */
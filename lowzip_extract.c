@@ -0,0 +1,377 @@
+/*
+ *  Parallel whole-archive extraction for lowzip, see lowzip_extract.h.
+ *
+ *  Files are planned from the central directory and sorted by size,
+ *  biggest first, so that the longest decodes start early and small files
+ *  fill in the gaps at the end.  The sorted plan is dealt round-robin into
+ *  one queue per worker.  A worker takes files from the front (biggest) of
+ *  its own queue and, once that's empty, steals from the back (smallest)
+ *  of the other queues.  Queues are only ever drained, so a worker is done
+ *  when one pass over all queues finds nothing.  Each queue has its own
+ *  lock which is held just to move an index.
+ *
+ *  Each worker owns a lowzip_state attached to the shared lowzip_archive
+ *  and an output window; file data is streamed to the sink.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "lowzip_extract.h"
+
+/* Streaming output window per worker, larger means fewer sink writes. */
+#define LOWZIP_EXTRACT_WINDOW_SIZE  (256L * 1024L)
+
+typedef struct {
+	pthread_mutex_t lock;
+	unsigned int head;  /* Next own file (biggest). */
+	unsigned int tail;  /* One past the last file (smallest). */
+} lowzip_extract_queue;
+
+typedef struct {
+	const lowzip_archive *ar;
+	lowzip_extract_entry *plan;
+	unsigned int count;
+	unsigned int threads;
+	const lowzip_sink *sink;
+	lowzip_extract_queue *queues;
+} lowzip_extract_job;
+
+typedef struct {
+	lowzip_extract_job *job;
+	unsigned int id;
+	int failures;
+	void *handle;  /* Sink handle of the file being extracted. */
+	unsigned char *window;
+	lowzip_state st;
+} lowzip_extract_worker;
+
+/*
+ *  Planning
+ */
+
+static int lowzip_extract_compare(const void *a, const void *b) {
+	const lowzip_extract_entry *ea = (const lowzip_extract_entry *) a;
+	const lowzip_extract_entry *eb = (const lowzip_extract_entry *) b;
+
+	if (ea->uncompressed_size != eb->uncompressed_size) {
+		return ea->uncompressed_size > eb->uncompressed_size ? -1 : 1;
+	}
+	return ea->offset < eb->offset ? -1 : (ea->offset > eb->offset ? 1 : 0);
+}
+
+int lowzip_extract_plan(lowzip_state *st, lowzip_extract_entry *plan, unsigned int max) {
+	lowzip_iter it;
+	lowzip_file *fi;
+	unsigned int count = 0;
+
+	lowzip_iter_begin(st, &it);
+	while ((fi = lowzip_iter_next(st, &it)) != NULL) {
+		if (count >= max) {
+			return -1;
+		}
+		plan[count].offset = it.entry_offset;
+		plan[count].uncompressed_size = fi->uncompressed_size;
+		plan[count].failed = 0;
+		count++;
+	}
+	if (st->have_error) {
+		return -1;
+	}
+
+	qsort((void *) plan, (size_t) count, sizeof(lowzip_extract_entry), lowzip_extract_compare);
+	return (int) count;
+}
+
+/*
+ *  Workers
+ */
+
+/* Callback wrappers: the worker is the state's 'udata' so that the write
+ * callback can find the current sink handle.
+ */
+static unsigned int lowzip_extract_read(void *udata, unsigned int offset) {
+	const lowzip_archive *ar = ((lowzip_extract_worker *) udata)->job->ar;
+	return ar->read_callback(ar->udata, offset);
+}
+
+static unsigned int lowzip_extract_read_span(void *udata, unsigned int offset, unsigned char *buf, unsigned int length) {
+	const lowzip_archive *ar = ((lowzip_extract_worker *) udata)->job->ar;
+	return ar->read_span_callback(ar->udata, offset, buf, length);
+}
+
+static int lowzip_extract_write(void *udata, const unsigned char *buf, unsigned int length) {
+	lowzip_extract_worker *w = (lowzip_extract_worker *) udata;
+	return w->job->sink->write(w->handle, buf, length);
+}
+
+/* Take the next file for worker 'w': own queue first, then steal. */
+static lowzip_extract_entry *lowzip_extract_take(lowzip_extract_worker *w) {
+	lowzip_extract_job *job = w->job;
+	lowzip_extract_queue *q;
+	unsigned int i;
+	unsigned int v;
+	unsigned int j;
+	int found;
+
+	for (i = 0; i < job->threads; i++) {
+		v = (w->id + i) % job->threads;
+		q = job->queues + v;
+		found = 0;
+		pthread_mutex_lock(&q->lock);
+		if (q->head < q->tail) {
+			j = (i == 0 ? q->head++ : --q->tail);
+			found = 1;
+		}
+		pthread_mutex_unlock(&q->lock);
+		if (found) {
+			return job->plan + v + j * job->threads;
+		}
+	}
+	return NULL;
+}
+
+static int lowzip_extract_file(lowzip_extract_worker *w, lowzip_extract_entry *e) {
+	const lowzip_sink *sink = w->job->sink;
+	lowzip_iter it;
+	lowzip_file *fi;
+	int failed;
+
+	it.entry_offset = e->offset;
+	it.next_offset = 0;
+	it.index = 0;
+	fi = lowzip_iter_locate(&w->st, &it);
+	if (!fi) {
+		return 1;
+	}
+	w->handle = sink->open(sink->udata, fi);
+	if (!w->handle) {
+		return 1;
+	}
+
+	w->st.output_start = w->window;
+	w->st.output_end = w->window + LOWZIP_EXTRACT_WINDOW_SIZE;
+	w->st.output_next = w->window;
+	lowzip_get_data(&w->st);
+
+	failed = w->st.have_error;
+	if (sink->close(w->handle, failed) != 0) {
+		failed = 1;
+	}
+	w->handle = NULL;
+	return failed;
+}
+
+static void *lowzip_extract_thread(void *arg) {
+	lowzip_extract_worker *w = (lowzip_extract_worker *) arg;
+	lowzip_extract_entry *e;
+
+	while ((e = lowzip_extract_take(w)) != NULL) {
+		e->failed = lowzip_extract_file(w, e);
+		w->failures += e->failed;
+	}
+	return NULL;
+}
+
+int lowzip_extract_all(const lowzip_archive *ar, lowzip_extract_entry *plan, unsigned int count,
+                       unsigned int threads, const lowzip_sink *sink) {
+	lowzip_extract_job job;
+	lowzip_extract_worker *workers = NULL;
+	pthread_t *tids = NULL;
+	unsigned char *started = NULL;
+	unsigned int i;
+	long n;
+	int failures = -1;
+
+	if (threads == 0) {
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (n > 0 ? (unsigned int) n : 1);
+	}
+	if (threads > count) {
+		threads = (count > 0 ? count : 1);
+	}
+
+	job.ar = ar;
+	job.plan = plan;
+	job.count = count;
+	job.threads = threads;
+	job.sink = sink;
+	job.queues = (lowzip_extract_queue *) calloc(threads, sizeof(lowzip_extract_queue));
+	workers = (lowzip_extract_worker *) calloc(threads, sizeof(lowzip_extract_worker));
+	tids = (pthread_t *) calloc(threads, sizeof(pthread_t));
+	started = (unsigned char *) calloc(threads, 1);
+	if (!job.queues || !workers || !tids || !started) {
+		goto done;
+	}
+
+	for (i = 0; i < threads; i++) {
+		/* Worker i gets plan entries i, i + threads, ... */
+		pthread_mutex_init(&job.queues[i].lock, NULL);
+		job.queues[i].head = 0;
+		job.queues[i].tail = (i < count ? (count - i + threads - 1) / threads : 0);
+	}
+	for (i = 0; i < threads; i++) {
+		workers[i].job = &job;
+		workers[i].id = i;
+		workers[i].window = (unsigned char *) malloc(LOWZIP_EXTRACT_WINDOW_SIZE);
+		if (!workers[i].window) {
+			goto cleanup;
+		}
+		lowzip_attach_archive(&workers[i].st, ar);
+		workers[i].st.udata = (void *) &workers[i];
+		if (ar->read_callback) {
+			workers[i].st.read_callback = lowzip_extract_read;
+		}
+		if (ar->read_span_callback) {
+			workers[i].st.read_span_callback = lowzip_extract_read_span;
+		}
+		workers[i].st.write_callback = lowzip_extract_write;
+	}
+
+	/* Worker 0 runs in the calling thread.  If a thread can't be
+	 * started, its queue is drained by stealing.
+	 */
+	for (i = 1; i < threads; i++) {
+		started[i] = (pthread_create(&tids[i], NULL, lowzip_extract_thread, (void *) &workers[i]) == 0);
+	}
+	(void) lowzip_extract_thread((void *) &workers[0]);
+	failures = 0;
+	for (i = 0; i < threads; i++) {
+		if (started[i]) {
+			pthread_join(tids[i], NULL);
+		}
+		failures += workers[i].failures;
+	}
+
+ cleanup:
+	for (i = 0; i < threads; i++) {
+		free(workers[i].window);
+		pthread_mutex_destroy(&job.queues[i].lock);
+	}
+
+ done:
+	free(job.queues);
+	free(workers);
+	free(tids);
+	free(started);
+	return failures;
+}
+
+/*
+ *  Directory sink
+ */
+
+/* Files are written to a temporary name next to the final one and renamed
+ * into place when complete, so that failed files leave nothing behind and
+ * duplicate names in the archive (extracted concurrently) don't interleave;
+ * one complete copy wins.
+ */
+#define LOWZIP_SINK_DIR_TEMP_SUFFIX  32
+
+typedef struct {
+	FILE *f;  /* NULL for a directory. */
+	char *temp;
+	char path[1];
+} lowzip_sink_dir_file;
+
+/* Reject names which would escape the output directory. */
+static int lowzip_sink_dir_name_ok(const char *name) {
+	const char *p;
+
+	if (name[0] == 0 || name[0] == '/') {
+		return 0;
+	}
+	for (p = name; *p; ) {
+		if (p[0] == '.' && p[1] == '.' && (p[2] == '/' || p[2] == 0)) {
+			return 0;
+		}
+		p = strchr(p, '/');
+		if (!p) {
+			break;
+		}
+		p++;
+	}
+	return 1;
+}
+
+static void *lowzip_sink_dir_open(void *udata, const lowzip_file *fi) {
+	const char *root = (const char *) udata;
+	lowzip_sink_dir_file *h;
+	size_t length;
+	char *p;
+
+	if (strlen(fi->filename) != fi->filename_length || !lowzip_sink_dir_name_ok(fi->filename)) {
+		return NULL;  /* Truncated name or embedded NUL would name another file. */
+	}
+	length = strlen(root) + 1 + strlen(fi->filename);
+	h = (lowzip_sink_dir_file *) malloc(sizeof(lowzip_sink_dir_file) + 2 * length + 1 + LOWZIP_SINK_DIR_TEMP_SUFFIX);
+	if (!h) {
+		return NULL;
+	}
+	h->f = NULL;
+	h->temp = h->path + length + 1;
+	snprintf(h->path, length + 1, "%s/%s", root, fi->filename);
+	snprintf(h->temp, length + LOWZIP_SINK_DIR_TEMP_SUFFIX, "%s.lowzip-%p", h->path, (void *) h);
+
+	/* Create the output directory and parent directories like
+	 * "mkdir -p"; other workers may race to create the same ones.
+	 */
+	for (p = h->path + 1; (p = strchr(p, '/')) != NULL; p++) {
+		*p = 0;
+		if (mkdir(h->path, 0777) != 0 && errno != EEXIST) {
+			free(h);
+			return NULL;
+		}
+		*p = '/';
+	}
+	if (h->path[length - 1] == '/') {
+		return (void *) h;  /* Directory entry, created above. */
+	}
+
+	h->f = fopen(h->temp, "wb");
+	if (!h->f) {
+		free(h);
+		return NULL;
+	}
+	return (void *) h;
+}
+
+static int lowzip_sink_dir_write(void *handle, const unsigned char *buf, unsigned int length) {
+	lowzip_sink_dir_file *h = (lowzip_sink_dir_file *) handle;
+
+	if (!h->f) {
+		return length > 0;  /* No data expected for a directory. */
+	}
+	return fwrite((const void *) buf, 1, (size_t) length, h->f) != (size_t) length;
+}
+
+static int lowzip_sink_dir_close(void *handle, int failed) {
+	lowzip_sink_dir_file *h = (lowzip_sink_dir_file *) handle;
+	int rc = 0;
+
+	if (h->f) {
+		rc = (fclose(h->f) != 0);
+		if (!failed && !rc) {
+			rc = (rename(h->temp, h->path) != 0);
+		}
+		if (failed || rc) {
+			(void) remove(h->temp);
+		}
+	}
+	free(h);
+	return rc;
+}
+
+void lowzip_sink_directory(lowzip_sink *sink, const char *path) {
+	sink->open = lowzip_sink_dir_open;
+	sink->write = lowzip_sink_dir_write;
+	sink->close = lowzip_sink_dir_close;
+	sink->udata = (void *) path;
+}
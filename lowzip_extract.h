@@ -0,0 +1,62 @@
+#if !defined(LOWZIP_EXTRACT_H_INCLUDED)
+#define LOWZIP_EXTRACT_H_INCLUDED
+
+/* Optional parallel whole-archive extraction on top of lowzip.  Unlike
+ * lowzip.c this needs a hosted POSIX platform: threads (pthreads), malloc()
+ * and stdio for the directory sink.
+ */
+
+#include "lowzip.h"
+
+#if !defined(LOWZIP_STREAMING) || !defined(LOWZIP_ITERATOR) || !defined(LOWZIP_SHARED_ARCHIVE)
+#error lowzip_extract.h requires LOWZIP_STREAMING, LOWZIP_ITERATOR and LOWZIP_SHARED_ARCHIVE, also when compiling lowzip.c
+#endif
+
+/* Output sink for extracted files.  open() is called with the file info of
+ * each file and returns a handle (NULL for failure), write() is called with
+ * consecutive chunks of file data and close() once at the end, with
+ * 'failed' set if the file failed (data already written must then be
+ * discarded).  write() and close() return non-zero on failure.  All three
+ * are called from worker threads, concurrently for different files.
+ */
+typedef struct {
+	void *(*open)(void *udata, const lowzip_file *fi);
+	int (*write)(void *handle, const unsigned char *buf, unsigned int length);
+	int (*close)(void *handle, int failed);
+	void *udata;
+} lowzip_sink;
+
+/* One file in an extraction plan: central directory entry offset, size
+ * for scheduling, and the result after extraction.
+ */
+typedef struct {
+	unsigned int offset;
+	unsigned int uncompressed_size;
+	int failed;
+} lowzip_extract_entry;
+
+/* Fill 'plan' (at most 'max' entries) with all files of the archive opened
+ * in 'st', sorted by size so that the biggest files are extracted first.
+ * Returns the number of files, or -1 if the central directory is corrupt
+ * or has more than 'max' files.
+ */
+extern int lowzip_extract_plan(lowzip_state *st, lowzip_extract_entry *plan, unsigned int max);
+
+/* Extract the files in 'plan' to 'sink' using 'threads' worker threads
+ * (zero for one per online CPU), each with its own lowzip_state attached
+ * to 'ar'.  Workers take files from their own queue biggest first and
+ * steal the smallest files from other queues when theirs runs out.
+ * Read callbacks of 'ar' must be thread safe.  Returns the number of
+ * failed files (-1 if workers can't be started), per file results are in
+ * plan[i].failed.
+ */
+extern int lowzip_extract_all(const lowzip_archive *ar, lowzip_extract_entry *plan, unsigned int count,
+                              unsigned int threads, const lowzip_sink *sink);
+
+/* Set up a sink which writes files under directory 'path', creating
+ * subdirectories as needed.  Names with absolute paths or '..' components
+ * fail instead of writing outside 'path'.  'path' must remain valid.
+ */
+extern void lowzip_sink_directory(lowzip_sink *sink, const char *path);
+
+#endif  /* LOWZIP_EXTRACT_H_INCLUDED */
@@ -0,0 +1,371 @@
+/*
+ *  Experimental parallel decoding of a single raw Deflate stream, see
+ *  lowzip_parallel.h.
+ *
+ *  The approach is the one used by pugz.  Decoding runs in phases, each
+ *  on all workers in parallel:
+ *
+ *    1. Worker 0 starts at the stream start, the others search their part
+ *       of the input for a block start (lowzip_find_chunk()).
+ *
+ *    2. Each worker decodes into 16-bit symbols until it reaches a block
+ *       start found by a later worker, or the end of the stream.  Bytes
+ *       of the unknown window before a chunk are placeholders.
+ *
+ *    3. Starting from worker 0, each chunk leads to the chunk whose start
+ *       it stopped at.  A found start which no chunk stops at may be a
+ *       false match; it's skipped (the preceding worker decodes past it)
+ *       so only real block boundaries are ever used.  Output offsets
+ *       follow from the chunk lengths.  The last 32kB of each chunk is
+ *       resolved in order, which is all the next chunk needs as its
+ *       window, and then the rest of every chunk in parallel.
+ *
+ *  BGZF files need none of this: blocks are independent and the index
+ *  gives the output offset of each, so workers decode consecutive runs of
+ *  blocks straight into the output.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "lowzip_parallel.h"
+
+/* Minimum compressed bytes per worker, smaller inputs use fewer workers. */
+#if !defined(LOWZIP_PARALLEL_MIN_CHUNK)
+#define LOWZIP_PARALLEL_MIN_CHUNK  (64L * 1024L)
+#endif
+
+/* Initial symbol buffer size per worker, grown as needed.  The block
+ * search needs room for a whole block, which is far less in practice.
+ */
+#define LOWZIP_PARALLEL_SYMBOLS  (1024L * 1024L)
+
+typedef struct lowzip_parallel_worker lowzip_parallel_worker;
+
+typedef struct {
+	const unsigned char *data;
+	unsigned int length;
+	unsigned int threads;
+	lowzip_bitpos *stops;  /* Chunk starts found. */
+	unsigned int num_stops;
+	unsigned char *out;
+	const lowzip_bgzf_index *bgzf;
+	void (*phase)(lowzip_parallel_worker *w);
+} lowzip_parallel_job;
+
+struct lowzip_parallel_worker {
+	lowzip_parallel_job *job;
+	unsigned int id;
+	pthread_t tid;
+	int found;     /* Chunk start found, always for worker 0. */
+	int failed;    /* Decode error or out of memory. */
+	int in_chain;  /* Chunk is part of the output. */
+	unsigned int out_offset;
+	unsigned int resolved;  /* Symbols resolved at the end of the chunk. */
+	lowzip_chunk ch;
+	lowzip_state st;
+};
+
+/* Phase 1: find the chunk start. */
+static void lowzip_parallel_find(lowzip_parallel_worker *w) {
+	lowzip_parallel_job *job = w->job;
+	unsigned int part;
+	unsigned int start;
+	unsigned int end;
+
+	w->st.input_data = job->data;
+	w->st.input_offset = 0;
+	w->st.input_length = job->length;
+
+	w->ch.symbols = (unsigned short *) malloc(LOWZIP_PARALLEL_SYMBOLS * sizeof(unsigned short));
+	if (!w->ch.symbols) {
+		w->failed = 1;
+		return;
+	}
+	w->ch.symbols_size = LOWZIP_PARALLEL_SYMBOLS;
+
+	if (w->id == 0) {
+		lowzip_start_chunk(&w->st, &w->ch);
+		w->found = 1;
+		return;
+	}
+	part = job->length / job->threads;
+	start = part * w->id;
+	end = (w->id + 1 == job->threads ? job->length : start + part);
+	w->found = lowzip_find_chunk(&w->st, &w->ch, start, end);
+}
+
+/* Phase 2: decode until a later chunk start or the end of the stream. */
+static void lowzip_parallel_decode(lowzip_parallel_worker *w) {
+	unsigned short *p;
+	unsigned int size;
+	int rc;
+
+	if (!w->found || w->failed) {
+		return;
+	}
+	w->ch.stops = w->job->stops;
+	w->ch.num_stops = w->job->num_stops;
+	for (;;) {
+		rc = lowzip_inflate_chunk(&w->st, &w->ch);
+		if (rc == LOWZIP_INFLATE_DONE) {
+			return;
+		}
+		if (rc != LOWZIP_INFLATE_NEED_OUTPUT || w->ch.symbols_size >= 0x40000000UL) {
+			break;
+		}
+		size = w->ch.symbols_size * 2U;
+		p = (unsigned short *) realloc((void *) w->ch.symbols, (size_t) size * sizeof(unsigned short));
+		if (!p) {
+			break;
+		}
+		w->ch.symbols = p;
+		w->ch.symbols_size = size;
+	}
+	w->failed = 1;
+}
+
+/* Window of up to 32kB preceding 'offset' in the output. */
+static unsigned int lowzip_parallel_window(unsigned int offset) {
+	return offset < 32768U ? offset : 32768U;
+}
+
+/* Phase 3: resolve the chunk except for its already resolved end. */
+static void lowzip_parallel_resolve(lowzip_parallel_worker *w) {
+	unsigned char *out = w->job->out + w->out_offset;
+	unsigned int wlen = lowzip_parallel_window(w->out_offset);
+
+	if (!w->in_chain) {
+		return;
+	}
+	if (lowzip_resolve_chunk(&w->ch, 0, w->ch.symbols_length - w->resolved, out - wlen, wlen, out) != 0) {
+		w->failed = 1;
+	}
+}
+
+/* BGZF: decode the worker's share of the blocks into the output. */
+static void lowzip_parallel_bgzf(lowzip_parallel_worker *w) {
+	lowzip_parallel_job *job = w->job;
+	const lowzip_bgzf_index *idx = job->bgzf;
+	lowzip_gzip_member m;
+	unsigned int part;
+	unsigned int extra;
+	unsigned int i;
+	unsigned int end;
+	unsigned int next;
+
+	part = idx->num_blocks / job->threads;
+	extra = idx->num_blocks % job->threads;
+	i = part * w->id + (w->id < extra ? w->id : extra);
+	end = i + part + (w->id < extra ? 1U : 0U);
+
+	w->st.zip_length = job->length;
+	w->st.input_data = job->data;
+	w->st.input_offset = 0;
+	w->st.input_length = job->length;
+
+	for (; i < end; i++) {
+		next = (i + 1 < idx->num_blocks ? idx->blocks[i + 1].uoffset : idx->uncompressed_size);
+		w->st.output_start = job->out + idx->blocks[i].uoffset;
+		w->st.output_end = job->out + next;
+		w->st.output_next = w->st.output_start;
+		lowzip_gzip_header(&w->st, idx->blocks[i].coffset, &m);
+		if (!w->st.have_error) {
+			lowzip_gzip_get_data(&w->st, &m);
+		}
+		if (w->st.have_error || w->st.output_next != w->st.output_end) {
+			w->failed = 1;
+			return;
+		}
+	}
+}
+
+static void *lowzip_parallel_thread(void *arg) {
+	lowzip_parallel_worker *w = (lowzip_parallel_worker *) arg;
+
+	w->job->phase(w);
+	return NULL;
+}
+
+/* Run 'phase' for all workers, worker 0 in the calling thread.  Workers
+ * whose thread can't be started are run in the calling thread afterwards.
+ */
+static void lowzip_parallel_run(lowzip_parallel_job *job, lowzip_parallel_worker *workers,
+                                void (*phase)(lowzip_parallel_worker *w)) {
+	unsigned char started[256];
+	unsigned int i;
+
+	job->phase = phase;
+	for (i = 1; i < job->threads; i++) {
+		started[i] = (pthread_create(&workers[i].tid, NULL, lowzip_parallel_thread, (void *) &workers[i]) == 0);
+	}
+	phase(&workers[0]);
+	for (i = 1; i < job->threads; i++) {
+		if (started[i]) {
+			pthread_join(workers[i].tid, NULL);
+		} else {
+			phase(&workers[i]);
+		}
+	}
+}
+
+/* Number of workers for 'threads' (zero for one per online CPU), at most
+ * 'max' and at least one.
+ */
+static unsigned int lowzip_parallel_threads(unsigned int threads, unsigned int max) {
+	long n;
+
+	if (threads == 0) {
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (n > 0 ? (unsigned int) n : 1);
+	}
+	if (threads > 256) {
+		threads = 256;
+	}
+	if (threads > max) {
+		threads = max;
+	}
+	return threads > 0 ? threads : 1;
+}
+
+int lowzip_inflate_parallel(const unsigned char *data, unsigned int length, unsigned int threads,
+                            unsigned char **out, unsigned int *out_length) {
+	lowzip_parallel_job job;
+	lowzip_parallel_worker *workers = NULL;
+	lowzip_parallel_worker *w;
+	unsigned int *stop_workers = NULL;
+	unsigned int total;
+	unsigned int tail;
+	unsigned int wlen;
+	unsigned int i;
+	int rc = 1;
+
+	*out = NULL;
+	*out_length = 0;
+
+	threads = lowzip_parallel_threads(threads, length / LOWZIP_PARALLEL_MIN_CHUNK);
+
+	memset((void *) &job, 0, sizeof(job));
+	job.data = data;
+	job.length = length;
+	job.threads = threads;
+	job.stops = (lowzip_bitpos *) calloc(threads, sizeof(lowzip_bitpos));
+	stop_workers = (unsigned int *) calloc(threads, sizeof(unsigned int));
+	workers = (lowzip_parallel_worker *) calloc(threads, sizeof(lowzip_parallel_worker));
+	if (!job.stops || !stop_workers || !workers) {
+		goto done;
+	}
+	for (i = 0; i < threads; i++) {
+		workers[i].job = &job;
+		workers[i].id = i;
+	}
+
+	lowzip_parallel_run(&job, workers, lowzip_parallel_find);
+
+	/* Chunk starts are in increasing order because the parts are. */
+	for (i = 1; i < threads; i++) {
+		if (workers[i].found && !workers[i].failed) {
+			job.stops[job.num_stops] = workers[i].ch.start;
+			stop_workers[job.num_stops++] = i;
+		}
+	}
+
+	lowzip_parallel_run(&job, workers, lowzip_parallel_decode);
+
+	/* Follow the chain of chunks from the stream start.  Stops are after
+	 * the chunk start, so the chain only moves forward.
+	 */
+	total = 0;
+	w = workers;
+	for (;;) {
+		if (w->failed || w->ch.symbols_length > 0xffffffffUL - total) {
+			goto done;
+		}
+		w->in_chain = 1;
+		w->out_offset = total;
+		total += w->ch.symbols_length;
+		if (w->ch.stop_index < 0) {
+			break;
+		}
+		w = workers + stop_workers[w->ch.stop_index];
+	}
+
+	job.out = (unsigned char *) malloc(total > 0 ? (size_t) total : 1);
+	if (!job.out) {
+		goto done;
+	}
+	for (i = 0; i < threads; i++) {
+		w = workers + i;
+		if (!w->in_chain) {
+			continue;
+		}
+		tail = lowzip_parallel_window(w->ch.symbols_length);
+		wlen = lowzip_parallel_window(w->out_offset);
+		if (lowzip_resolve_chunk(&w->ch, w->ch.symbols_length - tail, tail, job.out + w->out_offset - wlen, wlen,
+		                         job.out + w->out_offset + w->ch.symbols_length - tail) != 0) {
+			goto done;
+		}
+		w->resolved = tail;
+	}
+
+	lowzip_parallel_run(&job, workers, lowzip_parallel_resolve);
+	for (i = 0; i < threads; i++) {
+		if (workers[i].in_chain && workers[i].failed) {
+			goto done;
+		}
+	}
+
+	*out = job.out;
+	*out_length = total;
+	job.out = NULL;
+	rc = 0;
+
+ done:
+	if (workers) {
+		for (i = 0; i < threads; i++) {
+			free((void *) workers[i].ch.symbols);
+		}
+	}
+	free(job.out);
+	free(job.stops);
+	free(stop_workers);
+	free(workers);
+	return rc;
+}
+
+int lowzip_inflate_bgzf_parallel(const unsigned char *data, const lowzip_bgzf_index *idx, unsigned int threads,
+                                 unsigned char *out) {
+	lowzip_parallel_job job;
+	lowzip_parallel_worker *workers;
+	unsigned int i;
+	int rc = 0;
+
+	threads = lowzip_parallel_threads(threads, idx->num_blocks);
+
+	memset((void *) &job, 0, sizeof(job));
+	job.data = data;
+	job.length = idx->compressed_size;
+	job.threads = threads;
+	job.out = out;
+	job.bgzf = idx;
+	workers = (lowzip_parallel_worker *) calloc(threads, sizeof(lowzip_parallel_worker));
+	if (!workers) {
+		return 1;
+	}
+	for (i = 0; i < threads; i++) {
+		workers[i].job = &job;
+		workers[i].id = i;
+	}
+
+	lowzip_parallel_run(&job, workers, lowzip_parallel_bgzf);
+	for (i = 0; i < threads; i++) {
+		if (workers[i].failed) {
+			rc = 1;
+		}
+	}
+	free(workers);
+	return rc;
+}
@@ -0,0 +1,42 @@
+#if !defined(LOWZIP_PARALLEL_H_INCLUDED)
+#define LOWZIP_PARALLEL_H_INCLUDED
+
+/* Optional parallel decoding: experimental decoding of a single raw
+ * Deflate stream on top of lowzip's speculative chunk decoding, and BGZF
+ * files.  Like lowzip_extract.c this needs a hosted POSIX platform
+ * (pthreads, malloc).
+ */
+
+#include "lowzip.h"
+
+#if !defined(LOWZIP_SPECULATIVE) || !defined(LOWZIP_GZIP)
+#error lowzip_parallel.h requires LOWZIP_SPECULATIVE and LOWZIP_GZIP, also when compiling lowzip.c
+#endif
+
+/* Inflate raw Deflate 'data' ('length' bytes) using 'threads' worker
+ * threads (zero for one per online CPU).  The input is split into equal
+ * parts; the first worker decodes from the start and the others search
+ * their part for a block start and decode from there, with placeholders
+ * for the unknown window preceding it.  Once all workers are done,
+ * placeholders are resolved using the output of the preceding parts.
+ * Inputs too small to split are decoded by one worker.
+ *
+ * On success returns zero with the output in a malloc()'d buffer in '*out'
+ * ('*out_length' bytes), which the caller frees.  Returns non-zero for
+ * invalid input or if memory runs out.  Decoding uses about twice the
+ * output size of temporary memory.
+ */
+extern int lowzip_inflate_parallel(const unsigned char *data, unsigned int length, unsigned int threads,
+                                   unsigned char **out, unsigned int *out_length);
+
+/* Inflate BGZF 'data' indexed by lowzip_build_bgzf_index() into 'out',
+ * which must have room for idx->uncompressed_size bytes, using 'threads'
+ * worker threads (zero for one per online CPU).  Each worker decodes a
+ * run of consecutive blocks with its own lowzip_state, checking each
+ * against its trailer.  Returns zero on success, non-zero if any block
+ * fails or if memory runs out.
+ */
+extern int lowzip_inflate_bgzf_parallel(const unsigned char *data, const lowzip_bgzf_index *idx, unsigned int threads,
+                                        unsigned char *out);
+
+#endif  /* LOWZIP_PARALLEL_H_INCLUDED */
@@ -0,0 +1,56 @@
+#!/usr/bin/nodejs
+// Compress an input file into BGZF: gzip members of at most 65280 input
+// bytes each with a 'BC' extra subfield, followed by the empty EOF block.
+var fs = require('fs');
+var zlib = require('zlib');
+
+var inputFile = process.argv[2];
+if (typeof inputFile !== 'string') {
+    throw new Error('missing input file name');
+}
+var outputFile = process.argv[3];
+if (typeof outputFile !== 'string') {
+    throw new Error('missing output file name');
+}
+
+var crcTable = [];
+for (var n = 0; n < 256; n++) {
+    var c = n;
+    for (var k = 0; k < 8; k++) {
+        c = (c & 1) ? (0xedb88320 ^ (c >>> 1)) : (c >>> 1);
+    }
+    crcTable[n] = c >>> 0;
+}
+
+function crc32(buf) {
+    var crc = 0xffffffff;
+    for (var i = 0; i < buf.length; i++) {
+        crc = crcTable[(crc ^ buf[i]) & 0xff] ^ (crc >>> 8);
+    }
+    return (crc ^ 0xffffffff) >>> 0;
+}
+
+function block(data) {
+    var deflated = zlib.deflateRawSync(data, {});
+    var header = Buffer.from([ 0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0, 0 ]);
+    var trailer = Buffer.alloc(8);
+    var size = header.length + deflated.length + trailer.length;
+    if (size > 65536) {
+        throw new Error('block too large');
+    }
+    header.writeUInt16LE(size - 1, 16);
+    trailer.writeUInt32LE(crc32(data), 0);
+    trailer.writeUInt32LE(data.length, 4);
+    return Buffer.concat([ header, deflated, trailer ]);
+}
+
+var input = fs.readFileSync(inputFile);
+var blocks = [];
+for (var offset = 0; offset < input.length; offset += 65280) {
+    blocks.push(block(input.subarray(offset, offset + 65280)));
+}
+blocks.push(block(Buffer.alloc(0)));
+var output = Buffer.concat(blocks);
+console.log('compressed ' + inputFile + ' (' + input.length + ' bytes) to ' + outputFile + ' (' + output.length + ' bytes, ' + blocks.length + ' blocks)');
+
+fs.writeFileSync(outputFile, output);
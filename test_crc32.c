@@ -0,0 +1,116 @@
+/* Cross-check CRC-32 kernels against a bitwise reference on random data,
+ * lengths and alignments.  Includes lowzip.c directly to access the
+ * internal kernels; build with the same options as the library under test.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lowzip.c"
+
+#define TEST_BUFFER_SIZE  (1024 * 1024 + 64)
+#define TEST_ROUNDS       20000
+
+static unsigned int rnd_state = 0x12345678U;
+
+static unsigned int rnd(void) {
+	/* Simple LCG, good enough for test data. */
+	rnd_state = rnd_state * 1103515245U + 12345U;
+	return rnd_state >> 8U;
+}
+
+static unsigned int ref_crc32(const unsigned char *p, size_t len) {
+	unsigned int crc = 0xffffffffUL;
+	int i;
+
+	while (len-- > 0) {
+		crc ^= (unsigned int) (*p++);
+		for (i = 0; i < 8; i++) {
+			crc = (crc & 1U) ? (crc >> 1U) ^ 0xedb88320UL : (crc >> 1U);
+		}
+	}
+	return crc ^ 0xffffffffUL;
+}
+
+static int check(const char *kernel, unsigned int got, unsigned int expect, size_t align, size_t len) {
+	if (got != expect) {
+		printf("FAIL: %s, align %ld, length %ld: got 0x%08x, expected 0x%08x\n",
+		       kernel, (long) align, (long) len, got, expect);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned char *buf;
+	size_t i, align, len;
+	unsigned int expect;
+	int rounds;
+	int failures = 0;
+	int have_clmul = 0;
+
+	(void) argc;
+	(void) argv;
+
+	buf = (unsigned char *) malloc(TEST_BUFFER_SIZE);
+	if (!buf) {
+		return 1;
+	}
+	for (i = 0; i < TEST_BUFFER_SIZE; i++) {
+		buf[i] = (unsigned char) rnd();
+	}
+
+	/* Known answer. */
+	failures += check("crc32_update", lowzip_crc32_update(0xffffffffUL, (const unsigned char *) "123456789",
+	                  (const unsigned char *) "123456789" + 9) ^ 0xffffffffUL, 0xcbf43926UL, 0, 9);
+
+#if defined(LOWZIP_CRC32_CLMUL)
+	have_clmul = lowzip_crc32_have_clmul();
+#endif
+	printf("Kernels:");
+#if defined(LOWZIP_FAST_CRC32)
+	printf(" slice8");
+#endif
+	if (have_clmul) {
+		printf(" clmul");
+	}
+	printf(" crc32_update\n");
+
+	for (rounds = 0; rounds < TEST_ROUNDS; rounds++) {
+		align = rnd() % 16;
+		/* Mostly short lengths around the kernel thresholds, some long. */
+		if (rounds % 100 == 0) {
+			len = rnd() % (TEST_BUFFER_SIZE - 16);
+		} else {
+			len = rnd() % 1024;
+		}
+		expect = ref_crc32(buf + align, len);
+
+		failures += check("crc32_update", lowzip_crc32_update(0xffffffffUL, buf + align, buf + align + len) ^ 0xffffffffUL,
+		                  expect, align, len);
+#if defined(LOWZIP_FAST_CRC32)
+		failures += check("slice8", lowzip_crc32_slice8(0xffffffffUL, buf + align, buf + align + len) ^ 0xffffffffUL,
+		                  expect, align, len);
+#endif
+#if defined(LOWZIP_CRC32_CLMUL)
+		if (have_clmul && len >= 64) {
+			size_t n = len & ~((size_t) 15);
+			unsigned int crc;
+
+			crc = lowzip_crc32_clmul(0xffffffffUL, buf + align, buf + align + n);
+			crc = lowzip_crc32_slice8(crc, buf + align + n, buf + align + len);
+			failures += check("clmul", crc ^ 0xffffffffUL, expect, align, len);
+		}
+#endif
+		if (failures > 10) {
+			break;
+		}
+	}
+
+	free(buf);
+	if (failures > 0) {
+		printf("CRC-32 test failed, %d failures\n", failures);
+		return 1;
+	}
+	printf("CRC-32 test success, %d rounds\n", rounds);
+	return 0;
+}
@@ -3,6 +3,8 @@
 #include <string.h>
 #include <stddef.h>
 #include "lowzip.h"
+#include "lowzip_extract.h"
+#include "lowzip_parallel.h"
 
 typedef struct {
 	FILE *input;
@@ -53,7 +55,189 @@ unsigned int my_read(void *udata, unsigned int offset) {
 	return 0x100U;
 }
 
+/* Span read callback, reads directly from the file. */
+unsigned int my_read_span(void *udata, unsigned int offset, unsigned char *buf, unsigned int length) {
+	read_state *st;
+	size_t got;
+
+	st = (read_state *) udata;
+
+	if (offset >= st->input_length) {
+		fprintf(stderr, "OOB span read (offset %ld)\n", (long) offset);
+		return 0;
+	}
+	if (fseek(st->input, (long) offset, SEEK_SET) != 0) {
+		return 0;
+	}
+	got = fread((void *) buf, 1, (size_t) length, st->input);
+	return (unsigned int) got;
+}
+
+/* Output callback for streamed output, writes directly to stdout. */
+int my_write(void *udata, const unsigned char *buf, unsigned int length) {
+	(void) udata;
+	if (fwrite((const void *) buf, 1, (size_t) length, stdout) != (size_t) length) {
+		return 1;
+	}
+	return 0;
+}
+
+/* Output buffer size when streaming. */
+#define STREAM_BUFFER_SIZE  (64L * 1024L)
+
+/* Name index size (slots) for --name-index. */
+#define NAME_INDEX_SIZE  65537
+
+/* Offset table size for --offset-table; small so that archives with more
+ * files also exercise lookups past the table.
+ */
+#define OFFSET_TABLE_SIZE  7
+
+/* Index check: number of checkpoints at most and random range reads. */
+#define INDEX_MAX_POINTS    64
+#define INDEX_CHECK_RANGES  20
+
+/* Minimum BGZF block size (empty block), for sizing the block index. */
+#define BGZF_MIN_BLOCK  28
+
+/* Extract a file by building a checkpoint index and reading the whole file
+ * with lowzip_read_range(), then check random ranges against it.  The
+ * index is saved and loaded back in between, like an index file would be,
+ * which requires locating the file again using 'name' or 'file_index'.
+ */
+static int extract_located_file_indexed(lowzip_state *st, lowzip_file *fileinfo, int ignore_errors,
+                                        const char *name, int file_index) {
+	lowzip_index idx;
+	lowzip_index built;
+	unsigned char *saved = NULL;
+	unsigned int saved_size;
+	lowzip_index_point *pt;
+	unsigned int in_offset;
+	unsigned char *window = NULL;
+	unsigned char *data = NULL;
+	unsigned char *range = NULL;
+	unsigned int size;
+	unsigned int offset;
+	unsigned int length;
+	unsigned int rnd = 0x12345678U;
+	int i;
+	int retcode = 1;
+
+	fprintf(stderr, "Extracting %s using a checkpoint index (%ld bytes -> %ld bytes)\n",
+	        fileinfo->filename, (long) fileinfo->compressed_size,
+	        (long) fileinfo->uncompressed_size);
+	fflush(stderr);
+
+	size = fileinfo->uncompressed_size;
+	memset((void *) &built, 0, sizeof(built));
+	built.max_points = INDEX_MAX_POINTS;
+	built.points = (lowzip_index_point *) malloc(sizeof(lowzip_index_point) * INDEX_MAX_POINTS);
+	built.windows_size = INDEX_MAX_POINTS * 32768U;
+	built.windows = (unsigned char *) malloc(built.windows_size);
+	built.spacing = size / INDEX_MAX_POINTS > 65536U ? size / INDEX_MAX_POINTS : 65536U;
+	window = (unsigned char *) malloc(STREAM_BUFFER_SIZE);
+	data = (unsigned char *) malloc(size + 1);
+	range = (unsigned char *) malloc(size + 1);
+	if (!built.points || !built.windows || !window || !data || !range) {
+		fprintf(stderr, "Failed to allocate\n");
+		goto done;
+	}
+
+	st->write_callback = NULL;
+	st->output_start = window;
+	st->output_end = window + STREAM_BUFFER_SIZE;
+	st->output_next = window;
+
+	lowzip_build_index(st, &built);
+	if (!st->have_error) {
+		fprintf(stderr, "Index has %ld checkpoints, %ld bytes of windows\n",
+		        (long) built.num_points, (long) built.windows_used);
+
+		saved_size = lowzip_save_index(&built, NULL, 0);
+		saved = (unsigned char *) malloc(saved_size);
+		if (!saved || lowzip_save_index(&built, saved, saved_size) != saved_size) {
+			fprintf(stderr, "Failed to save index\n");
+			goto done;
+		}
+		if (!lowzip_locate_file(st, name ? 0 : file_index, name)) {
+			fprintf(stderr, "Failed to locate file again\n");
+			goto done;
+		}
+
+		/* A changed file must be detected. */
+		saved[12] ^= 0x01;
+		lowzip_load_index(st, &idx, saved, saved_size);
+		saved[12] ^= 0x01;
+		if (!st->have_error) {
+			fprintf(stderr, "Stale index not detected\n");
+			goto done;
+		}
+
+		/* So must a checkpoint past the end of the compressed data. */
+		if (built.num_points > 0) {
+			pt = (lowzip_index_point *) (saved + LOWZIP_INDEX_HEADER_SIZE) + built.num_points - 1;
+			in_offset = pt->in_offset;
+			pt->in_offset = built.compressed_size + 1;
+			lowzip_load_index(st, &idx, saved, saved_size);
+			pt->in_offset = in_offset;
+			if (!st->have_error) {
+				fprintf(stderr, "Corrupt index not detected\n");
+				goto done;
+			}
+		}
+
+		lowzip_load_index(st, &idx, saved, saved_size);
+		if (st->have_error) {
+			fprintf(stderr, "Failed to load index\n");
+			goto done;
+		}
+		lowzip_read_range(st, &idx, 0, data, size);
+	}
+	if (st->have_error) {
+		if (ignore_errors) {
+			fprintf(stderr, "Failed to extract (ignoring as requested)\n");
+			retcode = 0;
+		} else {
+			fprintf(stderr, "Failed to extract\n");
+		}
+		goto done;
+	}
+
+	for (i = 0; i < INDEX_CHECK_RANGES && size > 0; i++) {
+		rnd = rnd * 1103515245U + 12345U;
+		offset = (rnd >> 8) % size;
+		if (i < (int) idx.num_points) {
+			/* Ranges around checkpoints. */
+			offset = idx.points[i].out_offset - (i & 1);
+		}
+		rnd = rnd * 1103515245U + 12345U;
+		length = (rnd >> 8) % 70000U;
+		if (length > size - offset) {
+			length = size - offset;
+		}
+		lowzip_read_range(st, &idx, offset, range, length);
+		if (st->have_error || memcmp((void *) range, (void *) (data + offset), length) != 0) {
+			fprintf(stderr, "Range read mismatch: offset %ld, length %ld\n", (long) offset, (long) length);
+			goto done;
+		}
+	}
+
+	fwrite((void *) data, 1, (size_t) size, stdout);
+	fflush(stdout);
+	retcode = 0;
+
+ done:
+	free(built.points);
+	free(built.windows);
+	free(saved);
+	free(window);
+	free(data);
+	free(range);
+	return retcode;
+}
+
 static int extract_located_file(lowzip_state *st, lowzip_file *fileinfo, int ignore_errors) {
+	size_t buf_size;
 	void *buf = NULL;
 	int retcode = 1;
 
@@ -62,14 +246,15 @@ static int extract_located_file(lowzip_state *st, lowzip_file *fileinfo, int ign
 	        (long) fileinfo->uncompressed_size);
 	fflush(stderr);
 
-	buf = malloc(fileinfo->uncompressed_size);
+	buf_size = st->write_callback ? STREAM_BUFFER_SIZE : fileinfo->uncompressed_size;
+	buf = malloc(buf_size);
 	if (!buf) {
 		fprintf(stderr, "Failed to allocate\n");
 		return 1;
 	}
 
 	st->output_start = buf;
-	st->output_end = buf + fileinfo->uncompressed_size;
+	st->output_end = buf + buf_size;
 	st->output_next = st->output_start;
 
 	lowzip_get_data(st);
@@ -83,7 +268,9 @@ static int extract_located_file(lowzip_state *st, lowzip_file *fileinfo, int ign
 		}
 		fflush(stderr);
 	} else {
-		fwrite((void *) st->output_start, 1, (size_t) (st->output_next - st->output_start), stdout);
+		if (!st->write_callback) {
+			fwrite((void *) st->output_start, 1, (size_t) (st->output_next - st->output_start), stdout);
+		}
 		fflush(stdout);
 		retcode = 0;
 	}
@@ -93,11 +280,196 @@ static int extract_located_file(lowzip_state *st, lowzip_file *fileinfo, int ign
 	return retcode;
 }
 
-static int extract_raw_inflate(lowzip_state *st, int ignore_errors) {
+/* Extract all files under 'dir' using a pool of 'threads' workers
+ * (zero for one per CPU), report files which failed.
+ */
+static int extract_all_files(lowzip_state *st, const char *dir, unsigned int threads, int ignore_errors) {
+	lowzip_archive archive;
+	lowzip_extract_entry *plan;
+	lowzip_sink sink;
+	lowzip_iter iter;
+	lowzip_file *fileinfo;
+	unsigned int count = 0;
+	int planned;
+	int failures;
+	int i;
+
+	lowzip_iter_begin(st, &iter);
+	while (lowzip_iter_next(st, &iter) != NULL) {
+		count++;
+	}
+	plan = (lowzip_extract_entry *) malloc(sizeof(lowzip_extract_entry) * (count + 1));
+	if (!plan) {
+		fprintf(stderr, "Failed to allocate\n");
+		return 1;
+	}
+	planned = lowzip_extract_plan(st, plan, count + 1);
+	if (planned < 0) {
+		fprintf(stderr, "Failed to read central directory\n");
+		free(plan);
+		return 1;
+	}
+
+	fprintf(stderr, "Extracting %ld files to %s\n", (long) planned, dir);
+	fflush(stderr);
+
+	lowzip_export_archive(st, &archive);
+	lowzip_sink_directory(&sink, dir);
+	failures = lowzip_extract_all(&archive, plan, (unsigned int) planned, threads, &sink);
+	if (failures < 0) {
+		fprintf(stderr, "Failed to start extraction\n");
+		free(plan);
+		return 1;
+	}
+
+	for (i = 0; i < planned; i++) {
+		if (!plan[i].failed) {
+			continue;
+		}
+		iter.entry_offset = plan[i].offset;
+		fileinfo = lowzip_iter_locate(st, &iter);
+		fprintf(stderr, "Failed to extract %s\n", fileinfo ? fileinfo->filename : "(unknown)");
+	}
+	if (failures > 0 && ignore_errors) {
+		fprintf(stderr, "%ld files failed (ignoring as requested)\n", (long) failures);
+		failures = 0;
+	}
+	fflush(stderr);
+
+	free(plan);
+	return failures != 0;
+}
+
+/* Inflate raw deflate 'data' in parallel and write it to stdout.  With
+ * 'expect_length' >= 0 the output length must match it.
+ */
+static int inflate_parallel(const unsigned char *data, unsigned int length, unsigned int threads,
+                            long expect_length, int ignore_errors) {
+	unsigned char *out = NULL;
+	unsigned int out_length = 0;
+
+	if (lowzip_inflate_parallel(data, length, threads, &out, &out_length) != 0 ||
+	    (expect_length >= 0 && (long) out_length != expect_length)) {
+		free(out);
+		if (ignore_errors) {
+			fprintf(stderr, "Failed to inflate (ignoring as requested)\n");
+			return 0;
+		}
+		fprintf(stderr, "Failed to inflate\n");
+		return 1;
+	}
+	fwrite((void *) out, 1, (size_t) out_length, stdout);
+	fflush(stdout);
+	free(out);
+	return 0;
+}
+
+/* Extract a located file using parallel inflate, input must be in memory.
+ * Stored files are extracted as usual.
+ */
+static int extract_located_file_parallel(lowzip_state *st, lowzip_file *fileinfo, const unsigned char *data,
+                                         unsigned int length, unsigned int threads, int ignore_errors) {
+	if (fileinfo->compression_method != 8) {
+		return extract_located_file(st, fileinfo, ignore_errors);
+	}
+
+	fprintf(stderr, "Extracting %s in parallel (%ld bytes -> %ld bytes)\n",
+	        fileinfo->filename, (long) fileinfo->compressed_size,
+	        (long) fileinfo->uncompressed_size);
+	fflush(stderr);
+
+	if (fileinfo->data_offset > length || fileinfo->compressed_size > length - fileinfo->data_offset) {
+		fprintf(stderr, "Failed to extract\n");
+		return ignore_errors ? 0 : 1;
+	}
+	return inflate_parallel(data + fileinfo->data_offset, fileinfo->compressed_size, threads,
+	                        (long) fileinfo->uncompressed_size, ignore_errors);
+}
+
+/* Resumable raw inflate with input arriving in small chunks of varying
+ * size, like from a socket.  Input is fed from 'input' (whole input in
+ * memory) by growing the input window.
+ */
+static void inflate_resume_chunked(lowzip_state *st, const unsigned char *input, unsigned int input_length) {
+	unsigned int fed = 0;
+	unsigned int chunk = 1;
+	int rc;
+
+	st->read_callback = NULL;
+	st->read_span_callback = NULL;
+	st->input_data = input;
+	st->input_offset = 0;
+	st->input_length = 0;
+	st->input_more = 1;
+
+	lowzip_inflate_init(st);
+	for (;;) {
+		rc = lowzip_inflate_resume(st);
+		if (rc != LOWZIP_INFLATE_NEED_INPUT) {
+			break;
+		}
+		if (st->read_offset < st->input_offset) {
+			/* Rollback must stay within the window. */
+			fprintf(stderr, "Resume offset %ld before input window\n", (long) st->read_offset);
+			st->have_error = 1;
+			break;
+		}
+		if (fed >= input_length) {
+			st->input_more = 0;  /* End of input, next call finishes. */
+			continue;
+		}
+
+		/* Drop input before the resume offset, like a caller reusing
+		 * its receive buffer would.
+		 */
+		chunk = chunk * 7 % 263 + 1;
+		fed = (input_length - fed > chunk ? fed + chunk : input_length);
+		st->input_data = input + st->read_offset;
+		st->input_offset = st->read_offset;
+		st->input_length = fed - st->read_offset;
+	}
+}
+
+/* Push-style raw inflate with input arriving in small chunks of varying
+ * size.  Each chunk is copied into a receive buffer which is overwritten
+ * by the next chunk, so decoding must not depend on earlier chunks.
+ */
+static void inflate_push_chunked(lowzip_state *st, const unsigned char *input, unsigned int input_length) {
+	unsigned char recv_buf[264];
+	unsigned int fed = 0;
+	unsigned int chunk = 1;
+	int rc;
+
+	lowzip_inflate_init(st);
+	do {
+		chunk = chunk * 7 % 263 + 1;
+		if (chunk > input_length - fed) {
+			chunk = input_length - fed;
+		}
+		memcpy((void *) recv_buf, (const void *) (input + fed), chunk);
+		memset((void *) (recv_buf + chunk), 0xa5, sizeof(recv_buf) - chunk);
+		fed += chunk;
+
+		st->next_in = recv_buf;
+		st->avail_in = chunk;
+		rc = lowzip_inflate_push(st, fed >= input_length);
+		if (rc == LOWZIP_INFLATE_NEED_INPUT && st->avail_in != 0) {
+			fprintf(stderr, "Push input not consumed: %ld bytes left\n", (long) st->avail_in);
+			st->have_error = 1;
+			break;
+		}
+	} while (rc == LOWZIP_INFLATE_NEED_INPUT);
+}
+
+static int extract_raw_inflate(lowzip_state *st, int ignore_errors, const unsigned char *resume_data, unsigned int resume_length, int push) {
 	size_t buf_size = 256L * 1024L * 1024L;  /* 256MB just for testing; don't know size beforehand. */
 	void *buf = NULL;
 	int retcode = 1;
 
+	if (st->write_callback) {
+		buf_size = STREAM_BUFFER_SIZE;
+	}
+
 	buf = malloc(buf_size);
 	if (!buf) {
 		fprintf(stderr, "Failed to allocate\n");
@@ -109,7 +481,294 @@ static int extract_raw_inflate(lowzip_state *st, int ignore_errors) {
 	st->output_end = buf + buf_size;
 	st->output_next = st->output_start;
 
-	lowzip_inflate_raw(st);
+	if (resume_data && push) {
+		inflate_push_chunked(st, resume_data, resume_length);
+	} else if (resume_data) {
+		inflate_resume_chunked(st, resume_data, resume_length);
+	} else {
+		lowzip_inflate_raw(st);
+	}
+
+	if (st->have_error) {
+		if (ignore_errors) {
+			fprintf(stderr, "Failed to inflate (ignoring as requested)\n");
+			retcode = 0;
+		} else {
+			fprintf(stderr, "Failed to inflate\n");
+		}
+	} else {
+		if (!st->write_callback) {
+			fwrite((void *) st->output_start, 1, (size_t) (st->output_next - st->output_start), stdout);
+		}
+		retcode = 0;
+	}
+
+	return retcode;
+}
+
+/* Locate a file by name using a batch lookup of just that name. */
+static lowzip_file *locate_file_batch(lowzip_state *st, const char *name) {
+	lowzip_name_entry table[3];
+	lowzip_entry entry;
+
+	if (lowzip_locate_files(st, &name, 1, &entry, table, 3) != 1) {
+		st->have_error = 1;
+		return NULL;
+	}
+	return lowzip_locate_entry(st, &entry);
+}
+
+/* Batch lookup check: look up all filenames (in reverse order) and a few
+ * missing ones in one call, and check the results against iteration and,
+ * for some names, lowzip_locate_file().  Duplicate names must resolve to
+ * their first entry, and an empty batch must succeed.
+ */
+#define BATCH_MISSING_NAMES  2
+#define BATCH_CHECK_LOCATES  20
+
+static int check_batch_lookup(lowzip_state *st) {
+	lowzip_iter iter;
+	lowzip_file *fileinfo;
+	char **names = NULL;
+	unsigned int *offsets = NULL;
+	lowzip_entry *entries = NULL;
+	lowzip_name_entry *table = NULL;
+	lowzip_entry e;
+	unsigned int count = 0;
+	unsigned int expect = 0;
+	unsigned int found;
+	unsigned int size;
+	unsigned int i;
+	unsigned int j;
+	size_t len;
+	int retcode = 1;
+
+	if (lowzip_locate_files(st, NULL, 0, NULL, NULL, 0) != 0 || st->have_error) {
+		fprintf(stderr, "Empty batch lookup failed\n");
+		goto done;
+	}
+
+	lowzip_iter_begin(st, &iter);
+	while (lowzip_iter_next(st, &iter) != NULL) {
+		count++;
+	}
+	count += BATCH_MISSING_NAMES;
+	size = count * 2 + 1;
+	names = (char **) calloc(count, sizeof(char *));
+	offsets = (unsigned int *) calloc(count, sizeof(unsigned int));
+	entries = (lowzip_entry *) malloc(sizeof(lowzip_entry) * count);
+	table = (lowzip_name_entry *) malloc(sizeof(lowzip_name_entry) * size);
+	if (!names || !offsets || !entries || !table) {
+		fprintf(stderr, "Failed to allocate\n");
+		goto done;
+	}
+
+	i = count;
+	lowzip_iter_begin(st, &iter);
+	while (i > BATCH_MISSING_NAMES && (fileinfo = lowzip_iter_next(st, &iter)) != NULL) {
+		i--;
+		len = strlen(fileinfo->filename);
+		names[i] = (char *) malloc(len + 1);
+		if (!names[i]) {
+			fprintf(stderr, "Failed to allocate\n");
+			goto done;
+		}
+		memcpy((void *) names[i], (const void *) fileinfo->filename, len + 1);
+		offsets[i] = iter.entry_offset;
+		expect += (len < sizeof(fileinfo->filename) - 1);  /* Longer names are truncated. */
+	}
+	for (i = 0; i < BATCH_MISSING_NAMES; i++) {
+		names[i] = (char *) malloc(32);
+		if (!names[i]) {
+			fprintf(stderr, "Failed to allocate\n");
+			goto done;
+		}
+		sprintf(names[i], "lowzip-missing-%u/", i);
+	}
+
+	found = lowzip_locate_files(st, (const char * const *) names, count, entries, table, size);
+	if (st->have_error || found != expect) {
+		fprintf(stderr, "Batch lookup failed: %ld of %ld names found\n", (long) found, (long) expect);
+		goto done;
+	}
+	for (i = 0; i < count; i++) {
+		if (offsets[i] == 0 || strlen(names[i]) >= sizeof(fileinfo->filename) - 1) {
+			if (entries[i].offset != 0) {
+				fprintf(stderr, "Batch lookup found missing name %s\n", names[i]);
+				goto done;
+			}
+			continue;
+		}
+		e = entries[i];
+		fileinfo = lowzip_locate_entry(st, &e);
+		if (e.offset == 0 || e.offset > offsets[i] || !fileinfo || strcmp(fileinfo->filename, names[i]) != 0 ||
+		    fileinfo->local_header_offset != e.local_header_offset ||
+		    fileinfo->uncompressed_size != e.uncompressed_size) {
+			fprintf(stderr, "Batch lookup mismatch for %s\n", names[i]);
+			goto done;
+		}
+	}
+	for (j = 0; j < BATCH_CHECK_LOCATES && j < count; j++) {
+		i = (unsigned int) (((unsigned long) j * 7919UL) % count);
+		fileinfo = lowzip_locate_file(st, 0, names[i]);
+		if ((fileinfo ? fileinfo->local_header_offset : 0) != entries[i].local_header_offset) {
+			fprintf(stderr, "Batch lookup differs from lowzip_locate_file() for %s\n", names[i]);
+			goto done;
+		}
+	}
+	fprintf(stderr, "Batch lookup of %ld names found %ld\n", (long) count, (long) found);
+	retcode = 0;
+
+ done:
+	if (names) {
+		for (i = 0; i < count; i++) {
+			free(names[i]);
+		}
+	}
+	free(names);
+	free(offsets);
+	free(entries);
+	free(table);
+	return retcode;
+}
+
+/* Inflate all members of a gzip file in order.  Output of consecutive
+ * members is appended in the output buffer, or streamed.
+ */
+static void inflate_gzip_members(lowzip_state *st) {
+	lowzip_gzip_member m;
+	unsigned int offset = 0;
+
+	do {
+		if (st->write_callback) {
+			st->output_next = st->output_start;
+		}
+		lowzip_gzip_header(st, offset, &m);
+		if (st->have_error) {
+			return;
+		}
+		lowzip_gzip_get_data(st, &m);
+		if (st->have_error) {
+			return;
+		}
+		offset = m.end_offset;
+	} while (offset < st->zip_length);
+}
+
+/* Check random reads by virtual offset against the whole BGZF 'data'. */
+static int check_bgzf_reads(lowzip_state *st, const lowzip_bgzf_index *idx, const unsigned char *data) {
+	unsigned char *window = NULL;
+	unsigned char *range = NULL;
+	unsigned long long voffset;
+	unsigned int size = idx->uncompressed_size;
+	unsigned int offset;
+	unsigned int length;
+	unsigned int rnd = 0x12345678U;
+	int i;
+	int retcode = 1;
+
+	window = (unsigned char *) malloc(LOWZIP_BGZF_MAX_BLOCK);
+	range = (unsigned char *) malloc(size + 1);
+	if (!window || !range) {
+		fprintf(stderr, "Failed to allocate\n");
+		goto done;
+	}
+	st->output_start = window;
+	st->output_end = window + LOWZIP_BGZF_MAX_BLOCK;
+
+	for (i = 0; i < INDEX_CHECK_RANGES; i++) {
+		rnd = rnd * 1103515245U + 12345U;
+		offset = (size > 0 ? (rnd >> 8) % size : 0);
+		if (i < (int) idx->num_blocks) {
+			/* Ranges around block boundaries. */
+			offset = idx->blocks[i].uoffset - (offset > 0 && (i & 1) ? 1 : 0);
+		}
+		rnd = rnd * 1103515245U + 12345U;
+		length = (rnd >> 8) % 200000U;
+		if (length > size - offset) {
+			length = size - offset;
+		}
+		voffset = lowzip_bgzf_voffset(idx, offset);
+		lowzip_bgzf_read(st, idx, voffset, range, length);
+		if (st->have_error || memcmp((void *) range, (void *) (data + offset), length) != 0) {
+			fprintf(stderr, "BGZF read mismatch: offset %ld (virtual offset %llu), length %ld\n",
+			        (long) offset, voffset, (long) length);
+			goto done;
+		}
+	}
+	retcode = 0;
+
+ done:
+	free(window);
+	free(range);
+	return retcode;
+}
+
+/* Inflate a gzip file to stdout.  With 'parallel' or 'index_check' a BGZF
+ * block index is built first; BGZF files are then inflated in parallel
+ * (input must be in memory) or checked using random reads.  Other gzip
+ * files are inflated sequentially.
+ */
+static int extract_gzip(lowzip_state *st, const unsigned char *data, int parallel, unsigned int threads,
+                        int index_check, int ignore_errors) {
+	size_t buf_size = 256L * 1024L * 1024L;  /* 256MB just for testing; don't know size beforehand. */
+	lowzip_bgzf_index idx;
+	unsigned char *buf = NULL;
+	unsigned char *out = NULL;
+	size_t size;
+	int retcode = 1;
+
+	memset((void *) &idx, 0, sizeof(idx));
+	if (parallel || index_check) {
+		idx.max_blocks = st->zip_length / BGZF_MIN_BLOCK + 1;
+		idx.blocks = (lowzip_bgzf_block *) malloc(sizeof(lowzip_bgzf_block) * idx.max_blocks);
+		if (!idx.blocks) {
+			fprintf(stderr, "Failed to allocate\n");
+			goto done;
+		}
+		lowzip_build_bgzf_index(st, &idx);
+		if (st->have_error) {
+			fprintf(stderr, "Not a BGZF file, inflating sequentially\n");
+		} else {
+			fprintf(stderr, "BGZF file, %ld blocks (%ld bytes -> %ld bytes)\n", (long) idx.num_blocks,
+			        (long) idx.compressed_size, (long) idx.uncompressed_size);
+		}
+	}
+
+	if (parallel && idx.num_blocks > 0) {
+		out = (unsigned char *) malloc(idx.uncompressed_size + 1);
+		if (!out) {
+			fprintf(stderr, "Failed to allocate\n");
+			goto done;
+		}
+		st->have_error = (lowzip_inflate_bgzf_parallel(data, &idx, threads, out) != 0);
+		if (!st->have_error) {
+			fwrite((void *) out, 1, (size_t) idx.uncompressed_size, stdout);
+		}
+	} else {
+		if (st->write_callback) {
+			buf_size = STREAM_BUFFER_SIZE;
+		}
+		buf = (unsigned char *) malloc(buf_size);
+		if (!buf) {
+			fprintf(stderr, "Failed to allocate\n");
+			goto done;
+		}
+		st->output_start = buf;
+		st->output_end = buf + buf_size;
+		st->output_next = buf;
+		inflate_gzip_members(st);
+		if (!st->have_error && !st->write_callback) {
+			out = buf;
+			buf = NULL;
+			size = (size_t) (st->output_next - out);
+			if (index_check && idx.num_blocks > 0 &&
+			    (size != (size_t) idx.uncompressed_size || check_bgzf_reads(st, &idx, out) != 0)) {
+				goto done;
+			}
+			fwrite((void *) out, 1, size, stdout);
+		}
+	}
 
 	if (st->have_error) {
 		if (ignore_errors) {
@@ -119,10 +778,13 @@ static int extract_raw_inflate(lowzip_state *st, int ignore_errors) {
 			fprintf(stderr, "Failed to inflate\n");
 		}
 	} else {
-		fwrite((void *) st->output_start, 1, (size_t) (st->output_next - st->output_start), stdout);
 		retcode = 0;
 	}
 
+ done:
+	free(idx.blocks);
+	free(buf);
+	free(out);
 	return retcode;
 }
 
@@ -131,10 +793,31 @@ int main(int argc, char *argv[]) {
 	lowzip_state *st = NULL;
 	read_state read_st;
 	lowzip_file *fileinfo;
+	lowzip_iter iter;
 	const char *zip_filename = NULL;
 	const char *file_filename = NULL;
 	int ignore_errors = 0;
 	int raw_inflate = 0;
+	int gzip = 0;
+	int span_read = 0;
+	int mem_read = 0;
+	int stream_output = 0;
+	int resume_input = 0;
+	int push_input = 0;
+	int index_check = 0;
+	int name_index = 0;
+	int batch_lookup = 0;
+	lowzip_name_entry *name_table = NULL;
+	int attach = 0;
+	lowzip_archive archive;
+	lowzip_state *opener = NULL;
+	int offset_table = 0;
+	const char *extract_dir = NULL;
+	int parallel = 0;
+	unsigned int parallel_threads = 0;
+	unsigned int extract_threads = 0;
+	unsigned int *entry_table = NULL;
+	unsigned char *mem_data = NULL;
 	int file_index = -1;
 	int retcode = 1;
 	FILE *input = NULL;
@@ -158,6 +841,44 @@ int main(int argc, char *argv[]) {
 			ignore_errors = 1;
 		} else if (strcmp(argv[i], "--raw-inflate") == 0) {
 			raw_inflate = 1;
+		} else if (strcmp(argv[i], "--gzip") == 0) {
+			gzip = 1;
+		} else if (strcmp(argv[i], "--span-read") == 0) {
+			span_read = 1;
+		} else if (strcmp(argv[i], "--mem") == 0) {
+			mem_read = 1;
+		} else if (strcmp(argv[i], "--resume") == 0) {
+			resume_input = 1;
+			mem_read = 1;
+		} else if (strcmp(argv[i], "--push") == 0) {
+			resume_input = 1;
+			push_input = 1;
+			mem_read = 1;
+		} else if (strcmp(argv[i], "--attach") == 0) {
+			attach = 1;
+		} else if (strcmp(argv[i], "--extract-all") == 0 && i + 1 < argc) {
+			extract_dir = argv[++i];
+			mem_read = 1;  /* Workers share the input, my_read() isn't thread safe. */
+		} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%u", &extract_threads) != 1) {
+				goto invalid_args;
+			}
+		} else if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%u", &parallel_threads) != 1) {
+				goto invalid_args;
+			}
+			parallel = 1;
+			mem_read = 1;
+		} else if (strcmp(argv[i], "--offset-table") == 0) {
+			offset_table = 1;
+		} else if (strcmp(argv[i], "--name-index") == 0) {
+			name_index = 1;
+		} else if (strcmp(argv[i], "--batch") == 0) {
+			batch_lookup = 1;
+		} else if (strcmp(argv[i], "--index-check") == 0) {
+			index_check = 1;
+		} else if (strcmp(argv[i], "--stream") == 0) {
+			stream_output = 1;
 		} else if (strcmp(argv[i], "--test-repeat") == 0) {
 			repeat_count = 3;  /* For testing multiple reads per handle. */
 		} else {
@@ -196,34 +917,135 @@ int main(int argc, char *argv[]) {
 
 	st->udata = (void *) &read_st;
 	st->read_callback = my_read;
+	if (stream_output) {
+		st->write_callback = my_write;
+	}
+	if (span_read) {
+		st->read_span_callback = my_read_span;
+	}
+	if (mem_read) {
+		/* Read the whole input into memory. */
+		mem_data = (unsigned char *) malloc(read_st.input_length + 1);
+		if (!mem_data) {
+			goto alloc_error;
+		}
+		if (fseek(input, 0, SEEK_SET) != 0 ||
+		    fread((void *) mem_data, 1, (size_t) read_st.input_length, input) != (size_t) read_st.input_length) {
+			goto invalid_zip;
+		}
+	}
 	st->zip_length = read_st.input_length;
 
-	if (raw_inflate) {
+	if (gzip) {
+		fprintf(stderr, "Inflating (gzip) %s\n", zip_filename);
+
+		if (mem_data) {
+			st->read_callback = NULL;
+			st->input_data = mem_data;
+			st->input_offset = 0;
+			st->input_length = read_st.input_length;
+		}
+		if (extract_gzip(st, mem_data, parallel, parallel_threads, index_check, ignore_errors) == 0) {
+			retcode = 0;
+		}
+	} else if (raw_inflate) {
 		/* This is just for testing, the lowzip_inflate_raw() call
 		 * is not part of the actual API.
 		 */
 
 		fprintf(stderr, "Inflating (raw inflate) %s\n", zip_filename);
 
-		if (extract_raw_inflate(st, ignore_errors) == 0) {
+		if (mem_data) {
+			/* Input window covering the whole input, like
+			 * lowzip_init_archive_mem() but without parsing.
+			 */
+			st->read_callback = NULL;
+			st->input_data = mem_data;
+			st->input_offset = 0;
+			st->input_length = read_st.input_length;
+		}
+
+		if (parallel) {
+			if (inflate_parallel(mem_data, read_st.input_length, parallel_threads, -1, ignore_errors) == 0) {
+				retcode = 0;
+			}
+		} else if (extract_raw_inflate(st, ignore_errors, resume_input ? mem_data : NULL, read_st.input_length, push_input) == 0) {
 			retcode = 0;
 		}
 	} else {
-		lowzip_init_archive(st);
+		if (mem_data) {
+			lowzip_init_archive_mem(st, mem_data, read_st.input_length);
+		} else {
+			lowzip_init_archive(st);
+		}
 		if (st->have_error) {
 			fprintf(stderr, "Lowzip archive init failed\n");
 			goto done;
 		}
+		if (offset_table) {
+			entry_table = (unsigned int *) malloc(sizeof(unsigned int) * OFFSET_TABLE_SIZE);
+			if (!entry_table) {
+				goto alloc_error;
+			}
+			lowzip_build_offset_table(st, entry_table, OFFSET_TABLE_SIZE);
+			if (st->have_error) {
+				fprintf(stderr, "Failed to build offset table\n");
+				goto done;
+			}
+		}
+		if (name_index) {
+			name_table = (lowzip_name_entry *) malloc(sizeof(lowzip_name_entry) * NAME_INDEX_SIZE);
+			if (!name_table) {
+				goto alloc_error;
+			}
+			lowzip_build_name_index(st, name_table, NAME_INDEX_SIZE);
+			if (st->have_error) {
+				fprintf(stderr, "Failed to build name index\n");
+				goto done;
+			}
+		}
+
+		if (attach) {
+			/* Continue with a fresh state attached to the shared
+			 * archive handle, like a worker thread would.
+			 */
+			lowzip_export_archive(st, &archive);
+			opener = st;
+			st = (lowzip_state *) malloc(sizeof(*st));
+			if (!st) {
+				goto alloc_error;
+			}
+			lowzip_attach_archive(st, &archive);
+			if (stream_output) {
+				st->write_callback = my_write;
+			}
+		}
 
 	 repeat_test:
-		if (file_filename) {
-			fileinfo = lowzip_locate_file(st, 0, file_filename);
+		if (extract_dir) {
+			if (file_filename || file_index >= 0) {
+				goto invalid_args;
+			}
+			if (extract_all_files(st, extract_dir, extract_threads, ignore_errors) == 0) {
+				retcode = 0;
+			}
+		} else if (file_filename) {
+			if (batch_lookup) {
+				fileinfo = locate_file_batch(st, file_filename);
+			} else {
+				fileinfo = lowzip_locate_file(st, 0, file_filename);
+			}
 			if (!fileinfo) {
 				fprintf(stderr, "File %s not found in archive\n", file_filename);
 				goto done;
 			}
 
-			if (extract_located_file(st, fileinfo, ignore_errors) == 0) {
+			if (parallel) {
+				if (extract_located_file_parallel(st, fileinfo, mem_data, read_st.input_length, parallel_threads, ignore_errors) == 0) {
+					retcode = 0;
+				}
+			} else if ((index_check ? extract_located_file_indexed(st, fileinfo, ignore_errors, file_filename, 0) :
+			                          extract_located_file(st, fileinfo, ignore_errors)) == 0) {
 				retcode = 0;
 			}
 		} else if (file_index >= 0) {
@@ -233,13 +1055,30 @@ int main(int argc, char *argv[]) {
 				goto done;
 			}
 
-			if (extract_located_file(st, fileinfo, ignore_errors) == 0) {
+			if (parallel) {
+				if (extract_located_file_parallel(st, fileinfo, mem_data, read_st.input_length, parallel_threads, ignore_errors) == 0) {
+					retcode = 0;
+				}
+			} else if ((index_check ? extract_located_file_indexed(st, fileinfo, ignore_errors, NULL, file_index) :
+			                          extract_located_file(st, fileinfo, ignore_errors)) == 0) {
 				retcode = 0;
 			}
 		} else {
-			/* Without a file name/index, scan all files. */
+			/* Without a file name/index, list all files.  With an
+			 * offset table, locate each file by index instead of
+			 * iterating.  With --batch, check a batch lookup of
+			 * all names first.
+			 */
+			if (batch_lookup && check_batch_lookup(st) != 0) {
+				goto done;
+			}
+			lowzip_iter_begin(st, &iter);
 			for (i = 0; ; i++) {
-				fileinfo = lowzip_locate_file(st, i, NULL);
+				if (offset_table) {
+					fileinfo = lowzip_locate_file(st, i, NULL);
+				} else {
+					fileinfo = lowzip_iter_next(st, &iter);
+				}
 				if (!fileinfo) {
 					break;
 				}
@@ -256,12 +1095,20 @@ int main(int argc, char *argv[]) {
  done:
 	free(buf);
 	buf = NULL;
+	free(name_table);
+	name_table = NULL;
+	free(entry_table);
+	entry_table = NULL;
+	free(mem_data);
+	mem_data = NULL;
 	if (input) {
 		(void) fclose(input);
 		input = NULL;
 	}
 	free(st);
 	st = NULL;
+	free(opener);
+	opener = NULL;
 	return retcode;
 
  alloc_error:
@@ -276,6 +1123,23 @@ int main(int argc, char *argv[]) {
 	fprintf(stderr, "Usage: ./test_lowzip [--ignore-errors] foo.zip test.txt           # extract file to stdout\n"
 	                "       ./test_lowzip [--ignore-errors] foo.zip 3                  # extract Nth file to stdout\n"
 	                "       ./test_lowzip [--ignore-errors] foo.zip                    # list files to stdout\n"
-	                "       ./test_lowzip [--ignore-errors] --raw-inflate foo.deflate  # inflate raw deflate input to stdout\n");
+	                "       ./test_lowzip [--ignore-errors] --raw-inflate foo.deflate  # inflate raw deflate input to stdout\n"
+	                "       ./test_lowzip [--ignore-errors] --gzip foo.gz              # inflate gzip (multi-member, BGZF) input to stdout\n"
+	                "       ./test_lowzip [--ignore-errors] --extract-all DIR foo.zip  # extract all files under DIR in parallel\n"
+	                "\n"
+	                "       --span-read: read input using a span read callback\n"
+	                "       --mem: read input into memory and access it directly\n"
+	                "       --stream: stream output using a 64kB window and an output callback\n"
+	                "       --resume: raw inflate with input fed in small chunks using lowzip_inflate_resume()\n"
+	                "       --attach: use a fresh state attached to an exported archive handle\n"
+	                "       --offset-table: locate files by index using a central directory offset table\n"
+	                "       --name-index: locate files by name using a filename hash index\n"
+	                "       --batch: locate files by name using a batch lookup, check a batch lookup of all files\n"
+	                "       --index-check: extract using a saved and loaded checkpoint index (BGZF block index for --gzip),\n"
+	                "                      check random range reads\n"
+	                "       --parallel N: inflate using N threads with speculative block search, or by BGZF blocks\n"
+	                "                     for --gzip (0 for one per CPU)\n"
+	                "       --threads N: number of worker threads for --extract-all, default one per CPU\n"
+	                "       --push: raw inflate with input pushed in small chunks using lowzip_inflate_push()\n");
 	goto done;
 }